@@ -13,10 +13,55 @@
 #include <pthread.h>
 #include <span>
 #include <cerrno>
+#include <atomic>
+#include <algorithm>
+#include <climits>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <signal.h>
 
 #define KEYWORD_MAX_STRING 16        // Max keyword name or string length
 #define KEYWORD_STR_VAL_MAX_STRING 8 // Max size of a string keyword value
 #define KEYWORD_MAX_COMMENT 80       // Max comment size
+#define KEYWORD_INVALID_HANDLE UINT32_MAX // Handle returned when a keyword is not found
+
+#define SHMIO_FUTEX 0x0001      // Use futex words instead of pthread condition variables for the request/response handshake
+#define SHMIO_ALIGN_PAGE 0x0002 // Align the pixel region and each slot to SHMIO_PAGE_SIZE
+#define SHMIO_ALIGN_HUGE 0x0004 // Align the pixel region and each slot to SHMIO_HUGE_PAGE_SIZE
+#define SHMIO_HUGEPAGES 0x0008  // Back the segment with huge pages (hugetlbfs, falling back to transparent huge pages)
+#define SHMIO_PREFAULT 0x0010   // Fault in the whole mapping when it is created or opened
+#define SHMIO_MLOCK 0x0020      // Lock the mapping in RAM (implies SHMIO_PREFAULT)
+#define SHMIO_READONLY 0x0040   // Open a read-only consumer mapping, the segment is never written through it
+#define SHMIO_BACKPRESSURE 0x0080 // begin_write() waits until every registered reader released the slot it reuses
+#define SHMIO_PRIO_INHERIT 0x0100 // Create the stream mutex with PTHREAD_PRIO_INHERIT to bound priority inversion
+
+#define SHMIO_MAGIC 0x4F494D4853ULL          // "SHMIO", first word of every segment
+#define SHMIO_LAYOUT_VERSION 16               // Version of the segment layout
+#define SHMIO_CACHE_LINE 64                   // Cache line size, minimum alignment of the pixel region
+#define SHMIO_PAGE_SIZE 4096                  // Page size
+#define SHMIO_HUGE_PAGE_SIZE (2 * 1024 * 1024) // Huge page size
+#ifndef SHMIO_POLL_INTERVAL_NS
+#define SHMIO_POLL_INTERVAL_NS 100000 // Polling interval of read-only subscribers, which cannot park on a futex
+#endif
+#ifndef SHMIO_MAX_READERS
+#define SHMIO_MAX_READERS 16 // Entries of the reader table, part of the segment layout
+#endif
+#ifndef SHMIO_REQUEST_QUEUE_SIZE
+#define SHMIO_REQUEST_QUEUE_SIZE 64 // Entries of the ticketed request queue, a power of two of at least 8, part of the segment layout
+#endif
+#ifndef SHMIO_READER_CHECK_INTERVAL_NS
+#define SHMIO_READER_CHECK_INTERVAL_NS 100000000 // How often a writer held back by a reader checks that the reader is alive
+#endif
+#ifndef SHMIO_NOTIFY_ACCEPT_INTERVAL_NS
+#define SHMIO_NOTIFY_ACCEPT_INTERVAL_NS 10000000 // How often a producer looks for notification subscribers it was not told about
+#endif
+#ifndef SHMIO_HUGETLBFS_DIR
+#define SHMIO_HUGETLBFS_DIR "/dev/hugepages" // hugetlbfs mount point used by SHMIO_HUGEPAGES
+#endif
 
 #define _DATATYPE_UNINITIALIZED 0
 #define _DATATYPE_UINT8 1                 // uint8_t = char
@@ -65,16 +110,18 @@ namespace shmio
         STRING
     };
 
+    union KeywordData
+    {
+        int64_t numl;
+        double numf;
+        char valstr[KEYWORD_STR_VAL_MAX_STRING];
+    };
+
     struct Keyword
     {
         char name[KEYWORD_MAX_STRING];
         KeywordType type;
-        union
-        {
-            int64_t numl;
-            double numf;
-            char valstr[KEYWORD_STR_VAL_MAX_STRING];
-        } value;
+        KeywordData value;
         char comment[KEYWORD_MAX_COMMENT];
 
         Keyword(const char *_name, const KeywordType _type, int64_t _value, const char *_comment) : type(_type)
@@ -128,6 +175,64 @@ namespace shmio
         }
     };
 
+    struct KeywordValue // Hot part of a keyword stored in the segment, kept dense so value updates skip names and comments
+    {
+        KeywordType type;
+        uint32_t version; // bumped by every set_keyword_*() call
+        KeywordData value;
+    };
+
+    static_assert(sizeof(KeywordValue) == 16, "keyword values must pack four to a cache line");
+
+    struct KeywordRef // Logical view of a keyword in the segment, joining its cold metadata and its hot value
+    {
+        Keyword *meta = nullptr;     // name, type and comment
+        KeywordValue *hot = nullptr; // type and live value
+
+        explicit operator bool() const noexcept { return meta != nullptr; }
+        const char *name() const noexcept { return meta->name; }
+        KeywordType type() const noexcept { return hot->type; }
+        KeywordData &value() const noexcept { return hot->value; }
+        const char *comment() const noexcept { return meta->comment; }
+
+        Keyword load() const noexcept // copy of the keyword with its live value
+        {
+            Keyword keyword = *meta;
+            keyword.type = hot->type;
+            keyword.value = hot->value;
+            return keyword;
+        }
+    };
+
+    struct KeywordList // Range of KeywordRef over the keywords of a segment
+    {
+        Keyword *meta = nullptr;
+        KeywordValue *hot = nullptr;
+        size_t count = 0;
+
+        struct iterator
+        {
+            Keyword *meta;
+            KeywordValue *hot;
+
+            KeywordRef operator*() const noexcept { return KeywordRef{meta, hot}; }
+            iterator &operator++() noexcept
+            {
+                ++meta;
+                ++hot;
+                return *this;
+            }
+            bool operator==(const iterator &other) const noexcept { return meta == other.meta; }
+            bool operator!=(const iterator &other) const noexcept { return meta != other.meta; }
+        };
+
+        size_t size() const noexcept { return count; }
+        bool empty() const noexcept { return count == 0; }
+        KeywordRef operator[](const size_t _i) const noexcept { return KeywordRef{meta + _i, hot + _i}; }
+        iterator begin() const noexcept { return iterator{meta, hot}; }
+        iterator end() const noexcept { return iterator{meta + count, hot + count}; }
+    };
+
     enum class DataType : uint8_t
     {
         UINT8 = _DATATYPE_UINT8,
@@ -179,606 +284,3771 @@ namespace shmio
         __builtin_unreachable();
     }
 
-    struct SharedStorage
+    enum class WaitMode : uint32_t
     {
-        pthread_mutex_t mutex;
-        pthread_cond_t has_request_cond;
-        pthread_cond_t has_response_cond;
-        volatile bool has_request;
-        volatile bool has_response;
-        struct timespec creationtime;   // creation time
-        struct timespec lastaccesstime; // last access time
-        size_t nkw;                     // Number of keywords
-        size_t npx;                     // Size of data array in bytes
-        DataType dtype;                 // Data type
+        BLOCK,    // block in the kernel right away
+        SPIN,     // spin spin_count iterations, then block
+        SPIN_FOR, // spin for spin_ns nanoseconds, then block
+        BUSY_POLL // spin until ready, never block
     };
 
-    struct SharedMemory
+    struct WaitPolicy
     {
-        int fd = -1;
-        size_t size = 0;
-        std::string name{};
-        void *base = nullptr;
-        void *data = nullptr;
+        WaitMode mode = WaitMode::BLOCK;
+        uint32_t spin_count = 0; // iterations for WaitMode::SPIN
+        uint64_t spin_ns = 0;    // duration for WaitMode::SPIN_FOR
+    };
 
-        SharedMemory() = default;
+    struct WaitStats // How often each phase of a wait succeeded
+    {
+        uint64_t immediate = 0; // ready on the first check
+        uint64_t spin = 0;      // ready while spinning
+        uint64_t block = 0;     // ready after blocking
+        uint64_t timeout = 0;   // deadline passed before it was ready
+    };
 
-        SharedMemory(const SharedMemory &) = delete;
-        SharedMemory &operator=(const SharedMemory &) = delete;
+    struct ReaderCursor // Position and loss counters of one reader, kept by the reader itself
+    {
+        uint64_t next = 0;         // Index of the next frame to consume
+        uint64_t consumed = 0;     // Frames consumed
+        uint64_t skipped = 0;      // Frames published but never consumed
+        uint64_t overruns = 0;     // Copies discarded because the writer reused the slot mid-copy
+        uint64_t last_skipped = 0; // Frames skipped by the latest read
+        uint64_t last_overruns = 0; // Copies discarded by the latest read
+        int32_t reader = -1;       // Reader table entry taken by register_reader(), -1 if not registered
+        uint32_t epoch = 0;        // Epoch of the reader table entry, a mismatch means the reader was evicted
+    };
 
-        SharedMemory(SharedMemory &&other) noexcept : fd(other.fd), size(other.size), name(std::move(other.name)), base(other.base), data(other.data)
-        {
-            other.fd = -1;
-            other.size = 0;
-            other.base = nullptr;
-            other.data = nullptr;
-        }
+    enum class ReaderState : uint32_t
+    {
+        FREE,    // entry unused
+        CLAIMED, // entry being initialized by register_reader()
+        ACTIVE   // registered reader, holds back the writer under SHMIO_BACKPRESSURE
+    };
 
-        SharedMemory &operator=(SharedMemory &&other) noexcept
-        {
-            if (this != &other)
-            {
-                if (base != nullptr)
-                    munmap(base, size);
-                if (fd != -1)
-                    close(fd);
+    enum TicketState : uint64_t // State of a ticket, stored as ticket + state in RequestEntry::seq
+    {
+        TICKET_FREE = 0,      // entry free for the ticket
+        TICKET_REQUESTED = 1, // posted, not taken by a responder yet
+        TICKET_RESPONDED = 2, // answered, waiting to be collected
+        TICKET_CANCELLED = 3, // cancelled before a responder took it
+        TICKET_TAKEN = 4,     // taken by a responder
+        TICKET_ABANDONED = 5  // cancelled after a responder took it
+    };
 
-                fd = other.fd;
-                size = other.size;
-                name = std::move(other.name);
-                base = other.base;
-                data = other.data;
+    struct alignas(SHMIO_CACHE_LINE) RequestEntry // Ticketed request queue entry, one cache line per request
+    {
+        std::atomic<uint64_t> seq;      // ticket + TicketState, ticket + SHMIO_REQUEST_QUEUE_SIZE once freed
+        std::atomic<uint64_t> argument; // Argument of the request
+        std::atomic<uint64_t> result;   // Result of the response, e.g. the frame holding the data
+        std::atomic<int32_t> pid;       // Process of the requester, see reclaim_dead_tickets()
+        std::atomic<int32_t> responder; // Process of the responder that took the request, 0 until it is recorded
+    };
 
-                other.fd = -1;
-                other.size = 0;
-                other.base = nullptr;
-                other.data = nullptr;
-            }
-            return *this;
-        }
+    struct alignas(SHMIO_CACHE_LINE) ReaderEntry // Reader table entry, one cache line per reader
+    {
+        std::atomic<ReaderState> state; // Registration state
+        std::atomic<int32_t> pid;       // Process of the reader
+        std::atomic<uint64_t> consumed; // Frames released by the reader, the writer may reuse the slots of all frames below
+        std::atomic<uint64_t> heartbeat_ns; // CLOCK_MONOTONIC time the reader was last seen, see reader_heartbeat()
+        std::atomic<uint32_t> epoch;    // Bumped every time the entry is claimed
     };
 
-    inline size_t shared_memory_size(const size_t _nkw, const size_t _npx, const DataType _dtype)
+    struct FrameInfo // Metadata recorded by publish_frame()
     {
-        // shared_memory_size
-        //   Calculate the size of the shared memory.
-        // Parameters:
-        //   const size_t _nkw - number of keywords
-        //   const size_t _npx - number of pixels
-        //   const DataType _dtype - data type
-        // Return:
-        //   size_t size of the shared memory.
+        uint64_t frame = 0;        // Frame counter of the publish, 0 before the first one
+        uint64_t monotonic_ns = 0; // CLOCK_MONOTONIC time of the publish
+        uint64_t realtime_ns = 0;  // CLOCK_REALTIME time of the publish
+    };
 
-        size_t header_size = sizeof(SharedStorage);
-        size_t keywords_size = _nkw * sizeof(Keyword);
-        size_t pixels_size = _npx * DataTypeSize(_dtype);
-        return header_size + keywords_size + pixels_size;
+    // Memory model of the shared state. Every field written after creation is a lock-free atomic (or is accessed through
+    // std::atomic_ref), so it may be polled without the mutex:
+    //   - has_request / has_response are stored with release and loaded with acquire. a requester or responder that
+    //     fills data before posting publishes it to whoever observes the flag, with or without the mutex.
+    //   - write_seq / write_index are released by end_write() after the slot is filled and acquired by read_frame().
+    //     the odd write_seq of begin_write() is released too, so a reader that sees it also sees the frames before it.
+    //   - frame_count is released by publish_frame() and acquired by get_frame_count() / wait_for_frame().
+    //   - the info_* fields are written by publish_frame() under the info_seq seqlock and read by get_frame_info().
+    //     they are stored with release and loaded with acquire, so the recheck of info_seq needs no fence.
+    //   - keyword values are released by set_keyword_*() / write_keywords() and acquired by get_keyword_*() /
+    //     read_keywords(). the keywords_seq seqlock of the batches relies on those orders too, no fence.
+    //   - readers[].consumed is released by release_frames() once the reader is done with a slot and acquired by a
+    //     SHMIO_BACKPRESSURE writer before it reuses the slot.
+    //   - queue[].seq is released after argument / result / pid are stored and acquired before they are loaded, so a
+    //     request and its response are published by the state of its queue entry. every state change of an entry
+    //     that two processes may race on is a CAS on seq.
+    //   - coalesce_served is released by end_coalesced_frame() after the frame is produced and acquired by the
+    //     requesters it satisfies.
+    //   - the waiter counts and futex words use seq_cst so that a waiter and a waker cannot both miss each other.
+    //   - wait_policy and reader_timeout_ns are set with relaxed atomic_ref stores and read field by field.
+    //   - the pixel slots themselves are plain memory; the seqlock in read_frame() detects concurrent overwrites. it
+    //     needs the fences of begin_write_until() and copy_frame(), the only fences of the protocol.
+    // tests/tsan_stress_test.cpp checks the handshake, frame publication, keyword batches, the ring with its reader
+    // table, tickets, coalesced requests and notification under ThreadSanitizer. TSan does not model fences, so the
+    // ring is only driven under SHMIO_BACKPRESSURE, where no copy ever races the writer; torn copies of a ring that
+    // overwrites its readers are not covered.
+    // Fields of the segment description, the keywords and the keyword index are written once by the creator. The segment
+    // is visible to shm_open() as soon as it is created, so magic is stored last with release and valid_layout() acquires
+    // it: an opener that sees SHMIO_MAGIC sees a fully initialized segment.
+    struct SharedStorage
+    {
+        // ---- segment description, written once by the creator ----
+        uint64_t magic;                 // SHMIO_MAGIC, stored last by the creator
+        uint32_t version;               // Layout version (SHMIO_LAYOUT_VERSION)
+        uint32_t flags;                 // Creation flags (SHMIO_*)
+        uint64_t schema_hash;           // schema_hash() of dtype, npx and keyword names, types and comments
+        size_t nkw;                     // Number of keywords
+        size_t npx;                     // Size of data array in bytes
+        DataType dtype;                 // Data type
+        size_t nslots;                  // Number of frame slots in the ring buffer
+        size_t alignment;               // Alignment of the pixel region and of each slot
+        size_t values_offset;           // Offset of the keyword values (hot) from the start of the segment
+        size_t keywords_offset;         // Offset of the keyword names, types and comments (cold) from the start of the segment
+        size_t index_offset;            // Offset of the keyword hash index from the start of the segment
+        size_t pixels_offset;           // Offset of the first slot from the start of the segment
+        size_t slot_stride;             // Distance between two slots
+        struct timespec creationtime;   // creation time
+        WaitPolicy wait_policy;         // Default policy of wait_for_request(), wait_for_response() and wait_for_frame()
+        uint64_t reader_timeout_ns;     // Readers silent for longer are evicted by evict_dead_readers(), 0 to only evict dead processes
+
+        // ---- process-shared lock and condition variables ----
+        alignas(SHMIO_CACHE_LINE) pthread_mutex_t mutex;
+        alignas(SHMIO_CACHE_LINE) pthread_cond_t has_request_cond;
+        alignas(SHMIO_CACHE_LINE) pthread_cond_t has_response_cond;
+
+        // ---- request flag, written by requesters ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint32_t> has_request; // 1 while a request is pending, futex word of the futex backend
+        std::atomic<uint32_t> request_waiters;  // Futex backend, number of threads parked on has_request
+
+        // ---- response flag, written by the responder ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint32_t> has_response; // 1 while a response is pending, futex word of the futex backend
+        std::atomic<uint32_t> response_waiters; // Futex backend, number of threads parked on has_response
+
+        // ---- frame publication, written by the writer once per frame ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint64_t> write_index; // Index of the next frame to be written, frame k lives in slot k % nslots
+        std::atomic<uint64_t> write_seq;        // Sequence counter, 2 * frames written + 1 while a write is in progress
+        std::atomic<uint64_t> frame_count;      // Number of frames published, every subscriber sees each increment
+        std::atomic<uint64_t> response_index;   // write_index at the last response, frames written since were published by end_write()
+        std::atomic<uint32_t> frame_word;       // Futex word bumped on every publish
+        std::atomic<uint64_t> info_seq;         // Sequence counter of the info_* fields, odd while they are written
+        std::atomic<uint64_t> info_frame;       // FrameInfo::frame of the latest publish
+        std::atomic<uint64_t> info_monotonic_ns; // FrameInfo::monotonic_ns of the latest publish
+        std::atomic<uint64_t> info_realtime_ns; // FrameInfo::realtime_ns of the latest publish
+
+        // ---- keyword block ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint64_t> keywords_seq; // Sequence counter of write_keywords(), odd while a batch is written
+
+        // ---- subscribers ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint32_t> frame_waiters; // Number of subscribers parked on frame_word
+        std::atomic<uint32_t> notify_generation; // Bumped when a notification fd subscribes or unsubscribes
+
+        // ---- ticketed request queue ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint64_t> queue_tail; // Next ticket, written by requesters
+        std::atomic<uint32_t> queue_request_word;    // Futex word bumped on every ticketed request
+        std::atomic<uint32_t> queue_request_waiters; // Responders parked on queue_request_word
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint64_t> queue_head; // Next ticket to serve, written by responders
+        std::atomic<uint32_t> queue_response_word;    // Futex word bumped on every ticketed response
+        std::atomic<uint32_t> queue_response_waiters; // Requesters parked on queue_response_word
+        RequestEntry queue[SHMIO_REQUEST_QUEUE_SIZE]; // Ticketed requests, ticket t lives in entry t % SHMIO_REQUEST_QUEUE_SIZE
+
+        // ---- coalesced requests ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint64_t> coalesce_state; // Generation of the last begun frame << 32 | requests pending for the next one
+        std::atomic<uint32_t> coalesce_request_word;    // Futex word bumped on every coalesced request
+        std::atomic<uint32_t> coalesce_request_waiters; // Responders parked on coalesce_request_word
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint32_t> coalesce_served; // Generation of the last completed frame, futex word of the requesters
+        std::atomic<uint32_t> coalesce_served_waiters;  // Requesters parked on coalesce_served
+
+        // ---- reader table, written by registered readers ----
+        alignas(SHMIO_CACHE_LINE) std::atomic<uint32_t> release_word; // Futex word bumped when a reader releases frames or unregisters
+        std::atomic<uint32_t> release_waiters;  // Writers parked on release_word
+        ReaderEntry readers[SHMIO_MAX_READERS]; // Registered readers, see register_reader()
+
+        // ---- bookkeeping ----
+        alignas(SHMIO_CACHE_LINE) struct timespec lastaccesstime; // last access time, advisory, fields written with relaxed atomics
     };
 
-    inline SharedStorage *get_storage_ptr(SharedMemory &_memory)
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "shared atomics must be lock free");
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex words must be 32 bit");
+
+    inline void store_timespec(struct timespec &_dst, const struct timespec &_src)
     {
-        // get_storage
-        //   get a pointer to the storage.
-        // Parameters:
-        //   SharedMemory &_memory - shared memory
-        // Return:
-        //   SharedStorage pointer to the storage.
+        // store a timestamp field by field with relaxed atomics, readers may see a torn but race-free value
+        std::atomic_ref<time_t>(_dst.tv_sec).store(_src.tv_sec, std::memory_order_relaxed);
+        std::atomic_ref<long>(_dst.tv_nsec).store(_src.tv_nsec, std::memory_order_relaxed);
+    }
 
-        return reinterpret_cast<SharedStorage *>(_memory.base);
+    inline struct timespec load_timespec(struct timespec &_src)
+    {
+        struct timespec value;
+        value.tv_sec = std::atomic_ref<time_t>(_src.tv_sec).load(std::memory_order_relaxed);
+        value.tv_nsec = std::atomic_ref<long>(_src.tv_nsec).load(std::memory_order_relaxed);
+        return value;
     }
 
-    inline Keyword *get_keywords_ptr(SharedMemory &_memory)
+    inline int update_last_access_time(SharedStorage *_storage)
     {
-        // get_keywords
-        //   get a pointer to the keywords.
-        // Parameters:
-        //   SharedMemory &_memory - shared memory
-        // Return:
-        //   Keyword pointer to the keywords.
+        struct timespec now;
+        int ret = clock_gettime(CLOCK_REALTIME, &now);
+        store_timespec(_storage->lastaccesstime, now);
+        return ret;
+    }
+
+    inline void cpu_relax()
+    {
+        // hint the cpu that we are in a spin loop
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield" ::: "memory");
+#endif
+    }
 
-        return reinterpret_cast<Keyword *>(reinterpret_cast<char *>(_memory.base) + sizeof(SharedStorage));
+    inline uint64_t monotonic_ns()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<uint64_t>(now.tv_sec) * 1000000000ull + static_cast<uint64_t>(now.tv_nsec);
     }
 
-    inline std::span<Keyword> get_keywords(SharedMemory &_memory)
+    inline uint64_t timespec_ns(const struct timespec &_ts)
     {
-        SharedStorage *storage = get_storage_ptr(_memory);
-        return std::span<Keyword>(get_keywords_ptr(_memory), storage->nkw);
+        return static_cast<uint64_t>(_ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(_ts.tv_nsec);
     }
 
-    inline char *get_pixels_ptr(SharedMemory &_memory)
+    inline struct timespec ns_timespec(const uint64_t _ns)
     {
-        // get_data
-        //   get a pointer to the pixel data.
+        struct timespec ts;
+        ts.tv_sec = static_cast<time_t>(_ns / 1000000000ull);
+        ts.tv_nsec = static_cast<long>(_ns % 1000000000ull);
+        return ts;
+    }
+
+    inline struct timespec monotonic_deadline(const uint64_t _timeout_ns)
+    {
+        // monotonic_deadline
+        //   get the absolute CLOCK_MONOTONIC time _timeout_ns from now, as taken by the *_until wait functions.
         // Parameters:
-        //   SharedMemory &_memory - shared memory
+        //   const uint64_t _timeout_ns - relative timeout in nanoseconds
         // Return:
-        //   char * pointer to the pixel data.
+        //   struct timespec absolute deadline.
 
-        SharedStorage *storage = get_storage_ptr(_memory);
-        Keyword *keywords = get_keywords_ptr(_memory);
-        return reinterpret_cast<char *>(keywords) + storage->nkw * sizeof(Keyword);
+        uint64_t now = monotonic_ns();
+        return ns_timespec((_timeout_ns > UINT64_MAX - now) ? UINT64_MAX : now + _timeout_ns);
     }
 
-    template <typename T>
-    T *get_pixels_ptr_as(SharedMemory &_memory) // Templated pixel data access with type safety
+    enum class WaitPhase
     {
-        SharedStorage *storage = get_storage_ptr(_memory);
+        IMMEDIATE,
+        SPIN,
+        BLOCK
+    };
 
-        // Basic type checking (could be expanded)
-        if constexpr (std::is_same_v<T, uint8_t>)
-        {
-            if (storage->dtype != DataType::UINT8)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, int8_t>)
-        {
-            if (storage->dtype != DataType::INT8)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, uint16_t>)
-        {
-            if (storage->dtype != DataType::UINT16)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, int16_t>)
-        {
-            if (storage->dtype != DataType::INT16)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, uint32_t>)
-        {
-            if (storage->dtype != DataType::UINT32)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, int32_t>)
-        {
-            if (storage->dtype != DataType::INT32)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, uint64_t>)
-        {
-            if (storage->dtype != DataType::UINT64)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, int64_t>)
-        {
-            if (storage->dtype != DataType::INT64)
-                return nullptr;
-        }
-        else if constexpr (std::is_same_v<T, float>)
+    template <typename Ready>
+    inline WaitPhase spin_wait(const WaitPolicy &_policy, Ready &&_ready, const uint64_t _deadline_ns = UINT64_MAX)
+    {
+        // spin_wait
+        //   run the spinning phase of a wait policy.
+        // Parameters:
+        //   const WaitPolicy &_policy - wait policy
+        //   Ready &&_ready - predicate, true once the wait is satisfied
+        //   const uint64_t _deadline_ns - CLOCK_MONOTONIC time at which spinning stops regardless of the policy
+        // Return:
+        //   WaitPhase::IMMEDIATE or WaitPhase::SPIN if _ready() became true, WaitPhase::BLOCK if the caller has to block.
+
+        if (_ready())
+            return WaitPhase::IMMEDIATE;
+        uint64_t count = UINT64_MAX;
+        uint64_t deadline = _deadline_ns;
+        switch (_policy.mode)
         {
-            if (storage->dtype != DataType::FLOAT)
-                return nullptr;
+        case WaitMode::BLOCK:
+            return WaitPhase::BLOCK;
+        case WaitMode::SPIN:
+            count = _policy.spin_count;
+            break;
+        case WaitMode::SPIN_FOR:
+            deadline = std::min(deadline, monotonic_ns() + _policy.spin_ns);
+            break;
+        case WaitMode::BUSY_POLL:
+            break;
         }
-        else if constexpr (std::is_same_v<T, double>)
+        for (uint64_t i = 1; i <= count; ++i)
         {
-            if (storage->dtype != DataType::DOUBLE)
-                return nullptr;
+            cpu_relax();
+            if (_ready())
+                return WaitPhase::SPIN;
+            if ((i & 63) == 0 && deadline != UINT64_MAX && monotonic_ns() >= deadline) // read the clock every 64 iterations
+                break;
         }
-        else if constexpr (std::is_same_v<T, complex_float>)
+        return WaitPhase::BLOCK;
+    }
+
+    inline void count_wait(WaitStats *_stats, const WaitPhase _phase, const bool _ready)
+    {
+        // count_wait
+        //   count a finished wait in the phase it ended in. called once the wait returns, so a block that timed out is
+        //   counted as a timeout only.
+        // Parameters:
+        //   WaitStats *_stats - statistics, nullptr to count nothing
+        //   const WaitPhase _phase - phase returned by spin_wait()
+        //   const bool _ready - true if the wait was satisfied, false if it timed out
+
+        if (_stats == nullptr)
+            return;
+        if (!_ready)
         {
-            if (storage->dtype != DataType::COMPLEX_FLOAT)
-                return nullptr;
+            ++_stats->timeout;
+            return;
         }
-        else if constexpr (std::is_same_v<T, complex_double>)
+        switch (_phase)
         {
-            if (storage->dtype != DataType::COMPLEX_DOUBLE)
-                return nullptr;
+        case WaitPhase::IMMEDIATE:
+            ++_stats->immediate;
+            break;
+        case WaitPhase::SPIN:
+            ++_stats->spin;
+            break;
+        case WaitPhase::BLOCK:
+            ++_stats->block;
+            break;
         }
-
-        return reinterpret_cast<T *>(_memory.data);
     }
 
-    template <typename T>
-    inline std::span<T> get_pixels_as(SharedMemory &_memory)
+    inline void set_wait_policy(SharedStorage *_storage, const WaitPolicy &_policy)
     {
-        SharedStorage *storage = get_storage_ptr(_memory);
-        T *pixels_ptr = get_pixels_ptr_as<T>(_memory);
-        if (!pixels_ptr)
-            return {};
-        return std::span<T>(pixels_ptr, storage->npx);
+        // set_wait_policy
+        //   set the default wait policy of a stream, used by the wait functions called without a policy.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const WaitPolicy &_policy - wait policy
+
+        std::atomic_ref<WaitMode>(_storage->wait_policy.mode).store(_policy.mode, std::memory_order_relaxed);
+        std::atomic_ref<uint32_t>(_storage->wait_policy.spin_count).store(_policy.spin_count, std::memory_order_relaxed);
+        std::atomic_ref<uint64_t>(_storage->wait_policy.spin_ns).store(_policy.spin_ns, std::memory_order_relaxed);
     }
 
-    inline int close_shared_memory(SharedMemory &_memory)
+    inline WaitPolicy get_wait_policy(SharedStorage *_storage)
     {
-        // close_shared_memory
-        //   Close an open shared memory.
+        // get_wait_policy
+        //   get the default wait policy of a stream. the fields are loaded one by one, a wait racing set_wait_policy()
+        //   may mix the old and the new policy.
         // Parameters:
-        //   SharedMemory &_memory - memory
+        //   SharedStorage *_storage - storage
         // Return:
-        //   0 if stream closed correctly.
+        //   WaitPolicy of the stream.
 
-        if (_memory.base != nullptr)
-            munmap(_memory.base, _memory.size);
-        if (_memory.fd != -1)
-            close(_memory.fd);
-        // std::string path = shm_path(_memory.name);
-        // shm_unlink(path.c_str()); // TODO: remove the file
+        WaitPolicy policy;
+        policy.mode = std::atomic_ref<WaitMode>(_storage->wait_policy.mode).load(std::memory_order_relaxed);
+        policy.spin_count = std::atomic_ref<uint32_t>(_storage->wait_policy.spin_count).load(std::memory_order_relaxed);
+        policy.spin_ns = std::atomic_ref<uint64_t>(_storage->wait_policy.spin_ns).load(std::memory_order_relaxed);
+        return policy;
+    }
 
-        _memory.base = nullptr;
-        _memory.data = nullptr;
-        _memory.fd = -1;
-        _memory.size = 0;
+    inline long futex_wait(std::atomic<uint32_t> *_word, const uint32_t _expected, const struct timespec *_deadline = nullptr)
+    {
+        // futex_wait
+        //   park the calling thread while *_word == _expected. the word may live in memory shared between processes.
+        // Parameters:
+        //   std::atomic<uint32_t> *_word - futex word
+        //   const uint32_t _expected - value to sleep on
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 when woken, -1 with errno set otherwise (EAGAIN if the value already changed, ETIMEDOUT on deadline).
 
-        return 0;
+        // FUTEX_WAIT_BITSET takes an absolute CLOCK_MONOTONIC timeout, unlike the relative one of FUTEX_WAIT
+        return syscall(SYS_futex, reinterpret_cast<uint32_t *>(_word), FUTEX_WAIT_BITSET, _expected, _deadline, nullptr, FUTEX_BITSET_MATCH_ANY);
     }
 
-    inline std::string shm_path(const std::string &name)
+    inline long futex_wake(std::atomic<uint32_t> *_word, const int _count)
     {
-        return "/" + name + ".shm";
+        // futex_wake
+        //   wake up to _count threads parked on _word.
+        // Parameters:
+        //   std::atomic<uint32_t> *_word - futex word
+        //   const int _count - maximum number of threads to wake
+        // Return:
+        //   number of threads woken, -1 with errno set on failure.
+
+        return syscall(SYS_futex, reinterpret_cast<uint32_t *>(_word), FUTEX_WAKE, _count, nullptr, nullptr, 0);
     }
 
-    inline bool shared_memory_exists(const char *_name)
+    inline int futex_wait_while(std::atomic<uint32_t> *_word, std::atomic<uint32_t> *_waiters, const uint32_t _value, const struct timespec *_deadline = nullptr)
     {
-        // shared_memory_exists
-        //   Check if shared memory exists.
+        // futex_wait_while
+        //   block while *_word == _value. returns without a syscall if the word already changed.
         // Parameters:
-        //   const char* _name - name of the shared memory
+        //   std::atomic<uint32_t> *_word - futex word
+        //   std::atomic<uint32_t> *_waiters - waiter count checked by futex_store_wake()
+        //   const uint32_t _value - value to wait on
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
         // Return:
-        //   true if shared memory exists false otherwise
-        std::string path = shm_path(_name);
-        int fd = shm_open(path.c_str(), O_RDONLY, 0);
-        if (fd == -1)
+        //   0 once *_word != _value, -1 with errno ETIMEDOUT if the deadline passed first.
+
+        while (_word->load(std::memory_order_acquire) == _value)
         {
-            return false; // does not exist
+            long ret = 0;
+            _waiters->fetch_add(1, std::memory_order_seq_cst);
+            if (_word->load(std::memory_order_seq_cst) == _value) // pairs with the seq_cst store in futex_store_wake()
+                ret = futex_wait(_word, _value, _deadline);
+            _waiters->fetch_sub(1, std::memory_order_relaxed);
+            if (ret == -1 && errno == ETIMEDOUT && _word->load(std::memory_order_acquire) == _value)
+                return -1;
         }
-        close(fd);
-        return true; // exists
+        return 0;
     }
 
-    inline int setup_open_shared_memory(SharedMemory &_memory, const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords)
+    inline void futex_store_wake(std::atomic<uint32_t> *_word, std::atomic<uint32_t> *_waiters, const uint32_t _value)
     {
-        // setup_open_shared_memory
-        //   setup a shared memory. if a shared memory by that name exists an attempt will be made to use it.
+        // futex_store_wake
+        //   store _value and wake all parked threads. the FUTEX_WAKE syscall is only made if a waiter is registered.
         // Parameters:
-        //   SharedMemory &_memory - memory
-        //   const char *_name - filename
-        //   const size_t _npx - number of pixels
-        //   const DataType _dtype - type of pixels
-        //   const std::vector<Keyword> &_keywords - keywords
-        // Return:
-        //   0 if stream is created correctly. leaves the stream open.
+        //   std::atomic<uint32_t> *_word - futex word
+        //   std::atomic<uint32_t> *_waiters - waiter count maintained by futex_wait_while()
+        //   const uint32_t _value - value to store
 
-        if (_memory.name.empty())
-        {
-            return -1;
-        }
+        _word->store(_value, std::memory_order_seq_cst);
+        if (_waiters->load(std::memory_order_seq_cst) != 0)
+            futex_wake(_word, INT_MAX);
+    }
 
-        std::string path = shm_path(_memory.name);
-        _memory.fd = shm_open(path.c_str(), O_RDWR, 0); // Open existing shared memory object (read/write)
-        if (_memory.fd == -1)
-        {
+    inline uint64_t get_frame_count(SharedStorage *_storage)
+    {
+        // get_frame_count
+        //   get the number of frames published so far.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   uint64_t frame counter.
+
+        return _storage->frame_count.load(std::memory_order_acquire);
+    }
+
+    inline uint64_t realtime_ns()
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+        return timespec_ns(now);
+    }
+
+    inline uint64_t publish_frame(SharedStorage *_storage)
+    {
+        // publish_frame
+        //   advance the frame counter, record the FrameInfo of the publish and wake every subscriber parked in
+        //   wait_for_frame().
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   uint64_t new frame counter.
+
+        uint64_t seq = _storage->info_seq.load(std::memory_order_relaxed);
+        while ((seq & 1) || !_storage->info_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_relaxed)) // odd: info being written, serializes publishers
+        {
+            cpu_relax();
+            seq = _storage->info_seq.load(std::memory_order_relaxed);
+        }
+        uint64_t count = _storage->frame_count.fetch_add(1, std::memory_order_release) + 1;
+        _storage->info_frame.store(count, std::memory_order_release); // a reader that sees an info store sees the odd sequence
+        _storage->info_monotonic_ns.store(monotonic_ns(), std::memory_order_release);
+        _storage->info_realtime_ns.store(realtime_ns(), std::memory_order_release);
+        _storage->info_seq.store(seq + 2, std::memory_order_release); // even: info complete
+        _storage->frame_word.fetch_add(1, std::memory_order_seq_cst);
+        if (_storage->frame_waiters.load(std::memory_order_seq_cst) != 0)
+            futex_wake(&_storage->frame_word, INT_MAX);
+        return count;
+    }
+
+    inline FrameInfo get_frame_info(SharedStorage *_storage)
+    {
+        // get_frame_info
+        //   get a consistent snapshot of the metadata of the latest publish, without the mutex.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   FrameInfo of the latest publish, all zero before the first one.
+
+        FrameInfo info;
+        while (true)
+        {
+            uint64_t seq = _storage->info_seq.load(std::memory_order_acquire);
+            if (seq & 1) // publish in progress
+            {
+                cpu_relax();
+                continue;
+            }
+            info.frame = _storage->info_frame.load(std::memory_order_acquire); // acquire orders the sequence check after the info loads
+            info.monotonic_ns = _storage->info_monotonic_ns.load(std::memory_order_acquire);
+            info.realtime_ns = _storage->info_realtime_ns.load(std::memory_order_acquire);
+            if (_storage->info_seq.load(std::memory_order_relaxed) == seq)
+                return info;
+        }
+    }
+
+    inline uint64_t wait_for_frame_until(SharedStorage *_storage, const uint64_t _last_seen, const struct timespec *_deadline, const WaitPolicy &_policy, WaitStats *_stats = nullptr)
+    {
+        // wait_for_frame_until
+        //   wait until the frame counter is greater than _last_seen or _deadline passes. every subscriber is woken on
+        //   each publish.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _last_seen - last frame counter seen by the caller
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        //   const WaitPolicy &_policy - wait policy
+        //   WaitStats *_stats - if not null counts the phase the wait ended in, or the timeout
+        // Return:
+        //   uint64_t current frame counter, not greater than _last_seen (errno ETIMEDOUT) if the deadline passed.
+
+        WaitPhase phase = spin_wait(_policy, [&]
+                                    { return _storage->frame_count.load(std::memory_order_acquire) > _last_seen; },
+                                    _deadline ? timespec_ns(*_deadline) : UINT64_MAX);
+        while (true)
+        {
+            uint64_t count = _storage->frame_count.load(std::memory_order_acquire);
+            if (count > _last_seen)
+            {
+                count_wait(_stats, phase, true);
+                return count;
+            }
+            long ret = 0;
+            _storage->frame_waiters.fetch_add(1, std::memory_order_seq_cst);
+            uint32_t word = _storage->frame_word.load(std::memory_order_seq_cst);
+            if (_storage->frame_count.load(std::memory_order_seq_cst) <= _last_seen) // publish_frame() bumps the word after the counter
+                ret = futex_wait(&_storage->frame_word, word, _deadline);
+            _storage->frame_waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (ret == -1 && errno == ETIMEDOUT)
+            {
+                count = _storage->frame_count.load(std::memory_order_acquire);
+                count_wait(_stats, phase, count > _last_seen);
+                return count;
+            }
+        }
+    }
+
+    inline uint64_t wait_for_frame_until(SharedStorage *_storage, const uint64_t _last_seen, const struct timespec *_deadline)
+    {
+        return wait_for_frame_until(_storage, _last_seen, _deadline, get_wait_policy(_storage));
+    }
+
+    inline uint64_t wait_for_frame_for(SharedStorage *_storage, const uint64_t _last_seen, const uint64_t _timeout_ns)
+    {
+        struct timespec deadline = monotonic_deadline(_timeout_ns);
+        return wait_for_frame_until(_storage, _last_seen, &deadline);
+    }
+
+    inline uint64_t wait_for_frame(SharedStorage *_storage, const uint64_t _last_seen, const WaitPolicy &_policy, WaitStats *_stats = nullptr)
+    {
+        return wait_for_frame_until(_storage, _last_seen, nullptr, _policy, _stats);
+    }
+
+    inline uint64_t wait_for_frame(SharedStorage *_storage, const uint64_t _last_seen)
+    {
+        return wait_for_frame_until(_storage, _last_seen, nullptr, get_wait_policy(_storage));
+    }
+
+    struct NotifySubscriber
+    {
+        int sock; // Connection of the subscriber, reads EOF once it unsubscribes or exits
+        int efd;  // eventfd received from the subscriber, -1 until it arrives
+    };
+
+    struct NotifyState
+    {
+        int fd = -1;     // Subscriber: eventfd signalled on every publish
+        int sock = -1;   // Subscriber: connection that registered fd with the producer
+        int listen = -1; // Producer: socket accepting subscribers
+        std::vector<NotifySubscriber> subscribers{}; // Producer: registered subscribers
+        uint32_t generation = 0; // Producer: last notify_generation seen
+        uint64_t checked_ns = 0; // Producer: last time pending subscribers were accepted
+        std::atomic<bool> busy{false};    // Producer: try-lock of subscribers, generation and checked_ns, see notify_subscribers()
+        std::atomic<bool> pending{false}; // Producer: a publish whose signal is left to the thread holding busy
+
+        NotifyState() = default;
+
+        NotifyState(const NotifyState &) = delete;
+        NotifyState &operator=(const NotifyState &) = delete;
+
+        NotifyState(NotifyState &&other) noexcept : fd(other.fd), sock(other.sock), listen(other.listen), subscribers(std::move(other.subscribers)), generation(other.generation), checked_ns(other.checked_ns)
+        {
+            other.fd = -1;
+            other.sock = -1;
+            other.listen = -1;
+            other.subscribers.clear();
+        }
+
+        NotifyState &operator=(NotifyState &&other) noexcept
+        {
+            if (this != &other)
+            {
+                for (int f : {fd, sock, listen})
+                    if (f != -1)
+                        close(f);
+                for (NotifySubscriber &sub : subscribers)
+                {
+                    close(sub.sock);
+                    if (sub.efd != -1)
+                        close(sub.efd);
+                }
+
+                fd = other.fd;
+                sock = other.sock;
+                listen = other.listen;
+                subscribers = std::move(other.subscribers);
+                generation = other.generation;
+                checked_ns = other.checked_ns;
+
+                other.fd = -1;
+                other.sock = -1;
+                other.listen = -1;
+                other.subscribers.clear();
+            }
+            return *this;
+        }
+    };
+
+    struct SharedMemory
+    {
+        int fd = -1;
+        size_t size = 0;
+        std::string name{};
+        void *base = nullptr;
+        void *data = nullptr;
+        uint32_t flags = 0;   // Mapping flags this process opened the memory with
+        long prefaulted = 0;  // Minor faults taken up front by SHMIO_PREFAULT
+        NotifyState notify{}; // Notification fds of this process, see listen_notify() and open_notify_fd()
+
+        SharedMemory() = default;
+
+        SharedMemory(const SharedMemory &) = delete;
+        SharedMemory &operator=(const SharedMemory &) = delete;
+
+        SharedMemory(SharedMemory &&other) noexcept : fd(other.fd), size(other.size), name(std::move(other.name)), base(other.base), data(other.data), flags(other.flags), prefaulted(other.prefaulted), notify(std::move(other.notify))
+        {
+            other.fd = -1;
+            other.size = 0;
+            other.base = nullptr;
+            other.data = nullptr;
+            other.flags = 0;
+            other.prefaulted = 0;
+        }
+
+        SharedMemory &operator=(SharedMemory &&other) noexcept
+        {
+            if (this != &other)
+            {
+                if (base != nullptr)
+                    munmap(base, size);
+                if (fd != -1)
+                    close(fd);
+
+                fd = other.fd;
+                size = other.size;
+                name = std::move(other.name);
+                base = other.base;
+                data = other.data;
+                flags = other.flags;
+                prefaulted = other.prefaulted;
+                notify = std::move(other.notify);
+
+                other.fd = -1;
+                other.size = 0;
+                other.base = nullptr;
+                other.data = nullptr;
+                other.flags = 0;
+                other.prefaulted = 0;
+            }
+            return *this;
+        }
+    };
+
+    typedef uint32_t KeywordHandle; // Index of a keyword, stable for the lifetime of the segment
+
+    struct KeywordIndexEntry
+    {
+        uint32_t hash; // keyword_hash() of the name
+        uint32_t slot; // keyword index + 1, 0 if the entry is empty
+    };
+
+    constexpr size_t keyword_index_size(const size_t _nkw)
+    {
+        // number of entries of the open-addressing keyword index, a power of two at most half full
+        size_t size = 0;
+        if (_nkw > 0)
+        {
+            size = 1;
+            while (size < 2 * _nkw)
+                size <<= 1;
+        }
+        return size;
+    }
+
+    inline uint32_t keyword_hash(const char *_name)
+    {
+        // FNV-1a over the name, up to KEYWORD_MAX_STRING characters
+        uint32_t hash = 2166136261u;
+        for (size_t i = 0; i < KEYWORD_MAX_STRING && _name[i] != '\0'; ++i)
+        {
+            hash ^= static_cast<unsigned char>(_name[i]);
+            hash *= 16777619u;
+        }
+        return hash;
+    }
+
+    inline uint64_t schema_hash(const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords)
+    {
+        // schema_hash
+        //   64 bit FNV-1a fingerprint of a stream schema: dtype, npx and the name, type and comment of every keyword.
+        //   values are not part of the schema.
+        // Parameters:
+        //   const size_t _npx - number of pixels
+        //   const DataType _dtype - data type
+        //   const std::vector<Keyword> &_keywords - keywords
+        // Return:
+        //   uint64_t fingerprint.
+
+        uint64_t hash = 14695981039346656037ull;
+        auto mix = [&hash](const void *_data, const size_t _size)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(_data);
+            for (size_t i = 0; i < _size; ++i)
+            {
+                hash ^= bytes[i];
+                hash *= 1099511628211ull;
+            }
+        };
+        auto mix_string = [&mix](const char *_string, const size_t _max)
+        {
+            size_t length = strnlen(_string, _max);
+            mix(&length, sizeof(length));
+            mix(_string, length);
+        };
+
+        uint64_t npx = _npx;
+        uint8_t dtype = static_cast<uint8_t>(_dtype);
+        uint64_t nkw = _keywords.size();
+        mix(&npx, sizeof(npx));
+        mix(&dtype, sizeof(dtype));
+        mix(&nkw, sizeof(nkw));
+        for (const Keyword &keyword : _keywords)
+        {
+            int32_t type = static_cast<int32_t>(keyword.type);
+            mix_string(keyword.name, KEYWORD_MAX_STRING);
+            mix(&type, sizeof(type));
+            mix_string(keyword.comment, KEYWORD_MAX_COMMENT);
+        }
+        return hash;
+    }
+
+    struct SharedLayout
+    {
+        size_t alignment;       // Alignment of the pixel region and of each slot
+        size_t values_offset;   // Offset of the keyword values (hot)
+        size_t keywords_offset; // Offset of the keyword names, types and comments (cold)
+        size_t index_offset;    // Offset of the keyword hash index
+        size_t pixels_offset;   // Offset of the first slot
+        size_t slot_stride;     // Distance between two slots
+        size_t size;            // Total size of the segment
+    };
+
+    constexpr size_t align_up(const size_t _value, const size_t _alignment)
+    {
+        return (_value + _alignment - 1) / _alignment * _alignment;
+    }
+
+    constexpr size_t pixel_alignment(const uint32_t _flags)
+    {
+        if (_flags & SHMIO_ALIGN_HUGE)
+            return SHMIO_HUGE_PAGE_SIZE;
+        if (_flags & SHMIO_ALIGN_PAGE)
+            return SHMIO_PAGE_SIZE;
+        return SHMIO_CACHE_LINE;
+    }
+
+    inline SharedLayout shared_memory_layout(const size_t _nkw, const size_t _npx, const DataType _dtype, const size_t _nslots = 1, const uint32_t _flags = 0)
+    {
+        // shared_memory_layout
+        //   Calculate the layout of the shared memory: header, keyword values, keyword names and comments, keyword hash
+        //   index, then _nslots aligned frame slots.
+        // Parameters:
+        //   const size_t _nkw - number of keywords
+        //   const size_t _npx - number of pixels
+        //   const DataType _dtype - data type
+        //   const size_t _nslots - number of frame slots
+        //   const uint32_t _flags - creation flags, SHMIO_ALIGN_* select the pixel alignment
+        // Return:
+        //   SharedLayout offsets and size of the shared memory.
+
+        SharedLayout layout;
+        layout.alignment = pixel_alignment(_flags);
+        layout.values_offset = align_up(sizeof(SharedStorage), SHMIO_CACHE_LINE);
+        layout.keywords_offset = align_up(layout.values_offset + _nkw * sizeof(KeywordValue), SHMIO_CACHE_LINE);
+        layout.index_offset = align_up(layout.keywords_offset + _nkw * sizeof(Keyword), SHMIO_CACHE_LINE);
+        layout.pixels_offset = align_up(layout.index_offset + keyword_index_size(_nkw) * sizeof(KeywordIndexEntry), layout.alignment);
+        layout.slot_stride = align_up(_npx * DataTypeSize(_dtype), layout.alignment);
+        layout.size = layout.pixels_offset + _nslots * layout.slot_stride;
+        if (_flags & SHMIO_HUGEPAGES) // hugetlbfs files are sized in whole huge pages
+            layout.size = align_up(layout.size, SHMIO_HUGE_PAGE_SIZE);
+        return layout;
+    }
+
+    inline size_t shared_memory_size(const size_t _nkw, const size_t _npx, const DataType _dtype, const size_t _nslots = 1, const uint32_t _flags = 0)
+    {
+        // shared_memory_size
+        //   Calculate the size of the shared memory.
+        // Parameters:
+        //   const size_t _nkw - number of keywords
+        //   const size_t _npx - number of pixels
+        //   const DataType _dtype - data type
+        //   const size_t _nslots - number of frame slots
+        //   const uint32_t _flags - creation flags
+        // Return:
+        //   size_t size of the shared memory.
+
+        return shared_memory_layout(_nkw, _npx, _dtype, _nslots, _flags).size;
+    };
+
+    inline void *map_shared_memory(const int _fd, const size_t _size, const int _prot)
+    {
+        // map_shared_memory
+        //   map a shared memory at a SHMIO_HUGE_PAGE_SIZE aligned address so that pixel offsets aligned in the file are
+        //   aligned in memory as well.
+        // Parameters:
+        //   const int _fd - file descriptor
+        //   const size_t _size - size of the mapping
+        //   const int _prot - memory protection
+        // Return:
+        //   void * address of the mapping, MAP_FAILED on failure.
+
+        size_t reserved = _size + SHMIO_HUGE_PAGE_SIZE;
+        char *area = reinterpret_cast<char *>(mmap(nullptr, reserved, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0));
+        if (area == MAP_FAILED)
+            return MAP_FAILED;
+
+        char *start = area + (align_up(reinterpret_cast<uintptr_t>(area), SHMIO_HUGE_PAGE_SIZE) - reinterpret_cast<uintptr_t>(area));
+        void *base = mmap(start, _size, _prot, MAP_SHARED | MAP_FIXED, _fd, 0);
+        if (base == MAP_FAILED)
+        {
+            munmap(area, reserved);
+            return MAP_FAILED;
+        }
+
+        char *tail = start + align_up(_size, SHMIO_PAGE_SIZE);
+        if (start > area)
+            munmap(area, start - area);
+        if (area + reserved > tail)
+            munmap(tail, area + reserved - tail);
+        return base;
+    }
+
+    inline SharedStorage *get_storage_ptr(SharedMemory &_memory)
+    {
+        // get_storage
+        //   get a pointer to the storage.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   SharedStorage pointer to the storage.
+
+        return reinterpret_cast<SharedStorage *>(_memory.base);
+    }
+
+    inline Keyword *get_keywords_ptr(SharedMemory &_memory)
+    {
+        // get_keywords
+        //   get a pointer to the keyword names, types and comments. live values are in get_keyword_values_ptr().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   Keyword pointer to the keywords.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        return reinterpret_cast<Keyword *>(reinterpret_cast<char *>(_memory.base) + storage->keywords_offset);
+    }
+
+    inline KeywordValue *get_keyword_values_ptr(SharedMemory &_memory)
+    {
+        // get_keyword_values_ptr
+        //   get a pointer to the dense array of keyword values.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   KeywordValue pointer to the keyword values.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        return reinterpret_cast<KeywordValue *>(reinterpret_cast<char *>(_memory.base) + storage->values_offset);
+    }
+
+    inline KeywordList get_keywords(SharedMemory &_memory)
+    {
+        SharedStorage *storage = get_storage_ptr(_memory);
+        return KeywordList{get_keywords_ptr(_memory), get_keyword_values_ptr(_memory), storage->nkw};
+    }
+
+    inline std::span<KeywordIndexEntry> get_keyword_index(SharedMemory &_memory)
+    {
+        SharedStorage *storage = get_storage_ptr(_memory);
+        KeywordIndexEntry *index = reinterpret_cast<KeywordIndexEntry *>(reinterpret_cast<char *>(_memory.base) + storage->index_offset);
+        return std::span<KeywordIndexEntry>(index, keyword_index_size(storage->nkw));
+    }
+
+    inline void build_keyword_index(SharedMemory &_memory)
+    {
+        // build_keyword_index
+        //   fill the keyword hash index, done once by the creator. the first keyword of a given name wins.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+
+        std::span<Keyword> keywords(get_keywords_ptr(_memory), get_storage_ptr(_memory)->nkw);
+        std::span<KeywordIndexEntry> index = get_keyword_index(_memory);
+        std::fill(index.begin(), index.end(), KeywordIndexEntry{0, 0});
+        size_t mask = index.size() - 1;
+        for (size_t ikw = 0; ikw < keywords.size(); ++ikw)
+        {
+            uint32_t hash = keyword_hash(keywords[ikw].name);
+            size_t pos = hash & mask;
+            while (index[pos].slot != 0 && !(index[pos].hash == hash && std::strncmp(keywords[index[pos].slot - 1].name, keywords[ikw].name, KEYWORD_MAX_STRING) == 0))
+                pos = (pos + 1) & mask;
+            if (index[pos].slot == 0)
+                index[pos] = KeywordIndexEntry{hash, static_cast<uint32_t>(ikw + 1)};
+        }
+    }
+
+    inline KeywordHandle find_keyword_handle(SharedMemory &_memory, const char *_name)
+    {
+        // find_keyword_handle
+        //   look a keyword up through the hash index. the handle can be cached and passed to get_keyword().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const char *_name - keyword name
+        // Return:
+        //   KeywordHandle of the keyword, KEYWORD_INVALID_HANDLE if not found.
+
+        Keyword *keywords = get_keywords_ptr(_memory);
+        std::span<KeywordIndexEntry> index = get_keyword_index(_memory);
+        if (index.empty())
+            return KEYWORD_INVALID_HANDLE;
+        uint32_t hash = keyword_hash(_name);
+        size_t mask = index.size() - 1;
+        for (size_t pos = hash & mask; index[pos].slot != 0; pos = (pos + 1) & mask)
+        {
+            if (index[pos].hash == hash && std::strncmp(keywords[index[pos].slot - 1].name, _name, KEYWORD_MAX_STRING) == 0)
+                return index[pos].slot - 1;
+        }
+        return KEYWORD_INVALID_HANDLE;
+    }
+
+    inline KeywordRef get_keyword(SharedMemory &_memory, const KeywordHandle _handle)
+    {
+        // get_keyword
+        //   get a keyword from a handle returned by find_keyword_handle().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        // Return:
+        //   KeywordRef to the keyword, empty if the handle is invalid.
+
+        KeywordList keywords = get_keywords(_memory);
+        if (_handle >= keywords.size())
+            return KeywordRef{};
+        return keywords[_handle];
+    }
+
+    inline char *get_pixels_ptr(SharedMemory &_memory)
+    {
+        // get_data
+        //   get a pointer to the pixel data.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   char * pointer to the pixel data.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        return reinterpret_cast<char *>(_memory.base) + storage->pixels_offset;
+    }
+
+    inline size_t get_frame_size(SharedStorage *_storage)
+    {
+        // get_frame_size
+        //   get the size of a single frame slot.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   size_t size of a frame in bytes.
+
+        return _storage->npx * DataTypeSize(_storage->dtype);
+    }
+
+    inline char *get_slot_ptr(SharedMemory &_memory, const uint64_t _frame)
+    {
+        // get_slot_ptr
+        //   get a pointer to the slot holding a frame.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const uint64_t _frame - frame index
+        // Return:
+        //   char * pointer to the slot of frame _frame % nslots.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        return get_pixels_ptr(_memory) + (_frame % storage->nslots) * storage->slot_stride;
+    }
+
+    inline uint64_t get_write_index(SharedStorage *_storage)
+    {
+        // get_write_index
+        //   get the index of the next frame to be written. the latest complete frame is get_write_index() - 1.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   uint64_t index of the next frame.
+
+        return _storage->write_index.load(std::memory_order_acquire);
+    }
+
+    inline std::string shm_path(const std::string &name)
+    {
+        return "/" + name + ".shm";
+    }
+
+    inline std::string hugetlbfs_path(const std::string &name)
+    {
+        return std::string(SHMIO_HUGETLBFS_DIR) + shm_path(name);
+    }
+
+    inline int notify_address(const std::string &_name, struct sockaddr_un &_addr, socklen_t &_len)
+    {
+        // notify_address
+        //   get the abstract unix socket address on which the producer of a stream accepts notification subscribers.
+        // Parameters:
+        //   const std::string &_name - stream name
+        //   struct sockaddr_un &_addr - address
+        //   socklen_t &_len - address length
+        // Return:
+        //   0 on success, -1 with errno ENAMETOOLONG if the name does not fit.
+
+        std::string path = "shmio" + shm_path(_name);
+        if (path.size() + 1 > sizeof(_addr.sun_path))
+        {
+            errno = ENAMETOOLONG;
+            return -1;
+        }
+        std::memset(&_addr, 0, sizeof(_addr));
+        _addr.sun_family = AF_UNIX;
+        std::memcpy(_addr.sun_path + 1, path.data(), path.size()); // leading NUL: abstract namespace, nothing on disk
+        _len = static_cast<socklen_t>(offsetof(struct sockaddr_un, sun_path) + 1 + path.size());
+        return 0;
+    }
+
+    inline int listen_notify(SharedMemory &_memory)
+    {
+        // listen_notify
+        //   start accepting notification subscribers. called by the producer, whose end_write() and post_response()
+        //   then signal the eventfd of every subscriber.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   0 on success, -1 with errno set otherwise (EADDRINUSE if another process already listens for the stream).
+
+        if (_memory.notify.listen != -1)
+            return 0;
+        struct sockaddr_un addr;
+        socklen_t len;
+        if (notify_address(_memory.name, addr, len) == -1)
+            return -1;
+        int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (sock == -1)
+            return -1;
+        if (bind(sock, reinterpret_cast<struct sockaddr *>(&addr), len) == -1 || listen(sock, SOMAXCONN) == -1)
+        {
+            int err = errno;
+            close(sock);
+            errno = err;
+            return -1;
+        }
+        _memory.notify.listen = sock;
+        _memory.notify.generation = get_storage_ptr(_memory)->notify_generation.load(std::memory_order_acquire);
+        _memory.notify.checked_ns = monotonic_ns();
+        return 0;
+    }
+
+    inline bool notify_peer_allowed(SharedMemory &_memory, const int _sock)
+    {
+        // notify_peer_allowed
+        //   check that a subscriber connection comes from the user owning the segment. the abstract socket has no
+        //   file permissions, so any local process could connect otherwise.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const int _sock - subscriber connection
+        // Return:
+        //   true if the peer runs as the owner of the segment.
+
+        struct ucred cred;
+        socklen_t len = sizeof(cred);
+        struct stat st;
+        if (getsockopt(_sock, SOL_SOCKET, SO_PEERCRED, &cred, &len) == -1 || fstat(_memory.fd, &st) == -1)
+            return false;
+        return cred.uid == st.st_uid;
+    }
+
+    inline bool is_eventfd(const int _fd)
+    {
+        // is_eventfd
+        //   check that a file descriptor received from a peer is an eventfd, so signalling it cannot block on or
+        //   write into an arbitrary file.
+        // Parameters:
+        //   const int _fd - file descriptor
+        // Return:
+        //   true if _fd is an eventfd.
+
+        static const char expected[] = "anon_inode:[eventfd]";
+        char target[sizeof(expected)];
+        std::string path = "/proc/self/fd/" + std::to_string(_fd);
+        ssize_t n = readlink(path.c_str(), target, sizeof(target));
+        return n == static_cast<ssize_t>(sizeof(expected) - 1) && std::memcmp(target, expected, n) == 0;
+    }
+
+    inline int receive_notify_fd(const int _sock)
+    {
+        // receive_notify_fd
+        //   receive the eventfd a subscriber sends right after connecting, made non-blocking so a full counter never
+        //   stalls the producer.
+        // Parameters:
+        //   const int _sock - subscriber connection
+        // Return:
+        //   eventfd, -1 with errno EAGAIN if it has not arrived yet, -1 with another errno if the subscriber is gone or
+        //   sent something else than an eventfd (EPROTO).
+
+        char byte;
+        struct iovec iov = {&byte, 1};
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t n = recvmsg(_sock, &msg, MSG_DONTWAIT | MSG_CMSG_CLOEXEC);
+        if (n == -1)
+            return -1;
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        if (n == 0 || cmsg == nullptr || cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS)
+        {
+            errno = EPROTO;
+            return -1;
+        }
+        int efd;
+        std::memcpy(&efd, CMSG_DATA(cmsg), sizeof(int));
+        int flags = fcntl(efd, F_GETFL);
+        if (!is_eventfd(efd) || flags == -1 || fcntl(efd, F_SETFL, flags | O_NONBLOCK) == -1)
+        {
+            close(efd);
+            errno = EPROTO;
+            return -1;
+        }
+        return efd;
+    }
+
+    inline size_t accept_notify_subscribers_locked(SharedMemory &_memory)
+    {
+        // accept_notify_subscribers_locked
+        //   accept pending subscribers, collect their eventfds and drop the ones that closed their connection. only
+        //   subscribers running as the owner of the segment are accepted. the caller holds notify.busy.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   size_t number of registered subscribers.
+
+        NotifyState &notify = _memory.notify;
+        int sock;
+        while ((sock = accept4(notify.listen, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) != -1)
+        {
+            if (notify_peer_allowed(_memory, sock))
+                notify.subscribers.push_back(NotifySubscriber{sock, -1});
+            else
+                close(sock);
+        }
+        for (size_t i = 0; i < notify.subscribers.size();)
+        {
+            NotifySubscriber &sub = notify.subscribers[i];
+            bool alive;
+            if (sub.efd == -1)
+            {
+                sub.efd = receive_notify_fd(sub.sock);
+                alive = sub.efd != -1 || errno == EAGAIN;
+            }
+            else
+            {
+                char byte;
+                alive = recv(sub.sock, &byte, 1, MSG_DONTWAIT | MSG_PEEK) == -1 && errno == EAGAIN;
+            }
+            if (alive)
+            {
+                ++i;
+                continue;
+            }
+            close(sub.sock);
+            if (sub.efd != -1)
+                close(sub.efd);
+            notify.subscribers[i] = notify.subscribers.back();
+            notify.subscribers.pop_back();
+        }
+        return notify.subscribers.size();
+    }
+
+    inline size_t accept_notify_subscribers(SharedMemory &_memory)
+    {
+        // accept_notify_subscribers
+        //   accept_notify_subscribers_locked() under notify.busy, waiting for a concurrent notify_subscribers().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   size_t number of registered subscribers.
+
+        NotifyState &notify = _memory.notify;
+        while (notify.busy.exchange(true, std::memory_order_seq_cst))
+            cpu_relax();
+        size_t count = accept_notify_subscribers_locked(_memory);
+        notify.busy.store(false, std::memory_order_seq_cst);
+        return count;
+    }
+
+    inline size_t notify_subscribers(SharedMemory &_memory)
+    {
+        // notify_subscribers
+        //   signal the eventfd of every notification subscriber. a no-op unless listen_notify() was called. new and
+        //   departed subscribers are picked up when notify_generation changes, or every
+        //   SHMIO_NOTIFY_ACCEPT_INTERVAL_NS for read-only subscribers that cannot bump it.
+        //   end_write() and post_response() may run on different threads: the subscriber list is guarded by the
+        //   notify.busy try-lock, and a caller finding it taken leaves its signal to the holder through notify.pending,
+        //   so neither blocks and no publish goes unsignalled.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   size_t number of subscribers signalled by this call, 0 also if the signal was left to another thread.
+
+        NotifyState &notify = _memory.notify;
+        if (notify.listen == -1)
+            return 0;
+        size_t count = 0;
+        const uint64_t one = 1;
+        notify.pending.store(true, std::memory_order_seq_cst);
+        while (notify.pending.load(std::memory_order_seq_cst) && !notify.busy.exchange(true, std::memory_order_seq_cst))
+        {
+            notify.pending.store(false, std::memory_order_seq_cst); // signals of publishes up to here are sent below
+            uint32_t generation = get_storage_ptr(_memory)->notify_generation.load(std::memory_order_acquire);
+            uint64_t now = monotonic_ns();
+            if (generation != notify.generation || now - notify.checked_ns >= SHMIO_NOTIFY_ACCEPT_INTERVAL_NS)
+            {
+                notify.generation = generation;
+                notify.checked_ns = now;
+                accept_notify_subscribers_locked(_memory);
+            }
+            count = 0;
+            for (const NotifySubscriber &sub : notify.subscribers)
+                if (sub.efd != -1 && write(sub.efd, &one, sizeof(one)) == sizeof(one))
+                    ++count;
+            notify.busy.store(false, std::memory_order_seq_cst); // then recheck pending set by a caller that found busy
+        }
+        return count;
+    }
+
+    inline int open_notify_fd(SharedMemory &_memory)
+    {
+        // open_notify_fd
+        //   subscribe to the stream's notifications. the returned eventfd becomes readable (EPOLLIN) after each
+        //   frame or response the producer publishes, so one thread can epoll many streams. it stays owned by
+        //   _memory and is closed by close_notify() or close_shared_memory().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   non-blocking eventfd, -1 with errno set otherwise (ECONNREFUSED if the producer is not listening).
+
+        if (_memory.notify.fd != -1)
+            return _memory.notify.fd;
+        struct sockaddr_un addr;
+        socklen_t len;
+        if (notify_address(_memory.name, addr, len) == -1)
+            return -1;
+        int efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (efd == -1)
+            return -1;
+        int sock = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+        if (sock == -1)
+        {
+            close(efd);
+            return -1;
+        }
+
+        char byte = 0;
+        struct iovec iov = {&byte, 1};
+        alignas(struct cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+        std::memset(control, 0, sizeof(control));
+        struct msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+        std::memcpy(CMSG_DATA(cmsg), &efd, sizeof(int));
+        if (connect(sock, reinterpret_cast<struct sockaddr *>(&addr), len) == -1 || sendmsg(sock, &msg, MSG_NOSIGNAL) == -1)
+        {
+            int err = errno;
+            close(sock);
+            close(efd);
+            errno = err;
+            return -1;
+        }
+
+        _memory.notify.fd = efd;
+        _memory.notify.sock = sock;
+        if (!(_memory.flags & SHMIO_READONLY)) // read-only subscribers are found on the next accept interval
+            get_storage_ptr(_memory)->notify_generation.fetch_add(1, std::memory_order_release);
+        return efd;
+    }
+
+    inline uint64_t read_notify_fd(SharedMemory &_memory)
+    {
+        // read_notify_fd
+        //   consume the pending notifications of open_notify_fd().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   uint64_t number of notifications since the last call, 0 if there were none.
+
+        uint64_t count = 0;
+        if (_memory.notify.fd == -1 || read(_memory.notify.fd, &count, sizeof(count)) != sizeof(count))
+            return 0;
+        return count;
+    }
+
+    inline int close_notify(SharedMemory &_memory)
+    {
+        // close_notify
+        //   unsubscribe from notifications and stop accepting subscribers, closing every notification fd.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   0.
+
+        bool subscribed = _memory.notify.fd != -1;
+        _memory.notify = NotifyState{};
+        if (subscribed && _memory.base != nullptr && !(_memory.flags & SHMIO_READONLY))
+            get_storage_ptr(_memory)->notify_generation.fetch_add(1, std::memory_order_release);
+        return 0;
+    }
+
+    inline uint64_t get_min_reader_position(SharedStorage *_storage)
+    {
+        // get_min_reader_position
+        //   get the lowest consumed counter of the registered readers.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   uint64_t frames released by the slowest reader, UINT64_MAX if no reader is registered.
+
+        uint64_t position = UINT64_MAX;
+        for (ReaderEntry &entry : _storage->readers)
+            if (entry.state.load(std::memory_order_seq_cst) == ReaderState::ACTIVE)
+                position = std::min(position, entry.consumed.load(std::memory_order_acquire));
+        return position;
+    }
+
+    inline void wake_writer(SharedStorage *_storage)
+    {
+        _storage->release_word.fetch_add(1, std::memory_order_seq_cst);
+        if (_storage->release_waiters.load(std::memory_order_seq_cst) != 0)
+            futex_wake(&_storage->release_word, INT_MAX);
+    }
+
+    inline size_t evict_dead_readers(SharedStorage *_storage)
+    {
+        // evict_dead_readers
+        //   free the reader table entries of readers whose process no longer exists (kill(pid, 0) fails with ESRCH)
+        //   or, if reader_timeout_ns is set, whose heartbeat is older than that. called by a SHMIO_BACKPRESSURE writer
+        //   every SHMIO_READER_CHECK_INTERVAL_NS while it is held back.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   size_t number of readers evicted.
+
+        size_t evicted = 0;
+        uint64_t now = monotonic_ns();
+        uint64_t timeout = std::atomic_ref<uint64_t>(_storage->reader_timeout_ns).load(std::memory_order_relaxed);
+        for (ReaderEntry &entry : _storage->readers)
+        {
+            if (entry.state.load(std::memory_order_acquire) != ReaderState::ACTIVE)
+                continue;
+            pid_t pid = entry.pid.load(std::memory_order_relaxed);
+            uint64_t heartbeat = entry.heartbeat_ns.load(std::memory_order_relaxed);
+            bool dead = kill(pid, 0) == -1 && errno == ESRCH;
+            bool silent = timeout != 0 && now > heartbeat && now - heartbeat > timeout;
+            ReaderState expected = ReaderState::ACTIVE;
+            if ((dead || silent) && entry.state.compare_exchange_strong(expected, ReaderState::FREE, std::memory_order_release))
+                ++evicted;
+        }
+        if (evicted > 0)
+            wake_writer(_storage);
+        return evicted;
+    }
+
+    inline void set_reader_timeout(SharedStorage *_storage, const uint64_t _timeout_ns)
+    {
+        // set_reader_timeout
+        //   evict registered readers whose heartbeat is older than _timeout_ns, on top of readers whose process died.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _timeout_ns - heartbeat timeout, 0 to only evict dead processes
+
+        std::atomic_ref<uint64_t>(_storage->reader_timeout_ns).store(_timeout_ns, std::memory_order_relaxed);
+    }
+
+    inline int wait_for_readers_until(SharedStorage *_storage, const uint64_t _frame, const struct timespec *_deadline)
+    {
+        // wait_for_readers_until
+        //   wait until every registered reader has released the frame whose slot frame _frame reuses. spins per the
+        //   stream wait policy, then parks on release_word, evicting dead readers every SHMIO_READER_CHECK_INTERVAL_NS.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _frame - index of the frame about to be written
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 once the slot is free, -1 with errno ETIMEDOUT if the deadline passed first.
+
+        if (_frame < _storage->nslots)
+            return 0;
+        const uint64_t needed = _frame - _storage->nslots + 1;
+        auto released = [&]
+        { return get_min_reader_position(_storage) >= needed; };
+        uint64_t deadline_ns = _deadline ? timespec_ns(*_deadline) : UINT64_MAX;
+        if (spin_wait(get_wait_policy(_storage), released, deadline_ns) == WaitPhase::BLOCK)
+            evict_dead_readers(_storage);
+        while (!released())
+        {
+            uint64_t check_ns = monotonic_ns() + SHMIO_READER_CHECK_INTERVAL_NS;
+            struct timespec check = ns_timespec(std::min(check_ns, deadline_ns));
+            long ret = 0;
+            _storage->release_waiters.fetch_add(1, std::memory_order_seq_cst);
+            uint32_t word = _storage->release_word.load(std::memory_order_seq_cst);
+            if (!released()) // release_frames() bumps the word after the consumed counter
+                ret = futex_wait(&_storage->release_word, word, &check);
+            _storage->release_waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (ret == -1 && errno == ETIMEDOUT && !released())
+            {
+                if (check_ns >= deadline_ns)
+                {
+                    errno = ETIMEDOUT;
+                    return -1;
+                }
+                evict_dead_readers(_storage);
+            }
+        }
+        return 0;
+    }
+
+    inline char *begin_write_until(SharedMemory &_memory, const struct timespec *_deadline)
+    {
+        // begin_write_until
+        //   start writing the next frame. readers copying the slot being overwritten will retry. single writer only.
+        //   under SHMIO_BACKPRESSURE first waits, up to _deadline, until the registered readers released the slot.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   char * pointer to the slot to fill, nullptr with errno ETIMEDOUT if a reader held the slot past _deadline.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if ((storage->flags & SHMIO_BACKPRESSURE) && wait_for_readers_until(storage, get_write_index(storage), _deadline) == -1)
+            return nullptr;
+        uint64_t seq = storage->write_seq.load(std::memory_order_relaxed);
+        storage->write_seq.store(seq + 1, std::memory_order_release); // odd: write in progress, still releases the frames before it
+        std::atomic_thread_fence(std::memory_order_release);          // order the sequence bump before the pixel stores
+        return get_slot_ptr(_memory, storage->write_index.load(std::memory_order_relaxed));
+    }
+
+    inline char *begin_write(SharedMemory &_memory)
+    {
+        return begin_write_until(_memory, nullptr);
+    }
+
+    inline uint64_t end_write(SharedMemory &_memory)
+    {
+        // end_write
+        //   publish the frame started by begin_write() and notify wait_for_frame() subscribers.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   uint64_t index of the frame just published.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        uint64_t frame = storage->write_index.load(std::memory_order_relaxed);
+        storage->write_index.store(frame + 1, std::memory_order_release);
+        uint64_t seq = storage->write_seq.load(std::memory_order_relaxed);
+        storage->write_seq.store(seq + 1, std::memory_order_release); // even: frame complete
+        publish_frame(storage);
+        notify_subscribers(_memory);
+        return frame;
+    }
+
+    inline uint64_t oldest_readable_frame(SharedStorage *_storage, const uint64_t _seq)
+    {
+        // oldest_readable_frame
+        //   get the oldest frame whose slot is not being reused at write sequence _seq.
+        // Parameters:
+        //   SharedStorage *_storage - shared storage
+        //   const uint64_t _seq - value of write_seq
+        // Return:
+        //   uint64_t frame index, equal to _seq >> 1 if no complete frame is readable.
+
+        uint64_t started = (_seq + 1) >> 1; // includes a frame being written
+        return started > _storage->nslots ? started - _storage->nslots : 0;
+    }
+
+    inline int copy_frame(SharedMemory &_memory, const uint64_t _frame, void *_dst)
+    {
+        // copy_frame
+        //   copy the slot of a frame already checked complete and readable, then check the writer did not start
+        //   reusing it during the copy.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const uint64_t _frame - frame index
+        //   void *_dst - destination of get_frame_size() bytes
+        // Return:
+        //   0 if the copy is intact, -1 if the slot was overwritten during the copy.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        std::memcpy(_dst, get_slot_ptr(_memory, _frame), get_frame_size(storage));
+
+        std::atomic_thread_fence(std::memory_order_acquire); // order the pixel loads before the sequence check
+        uint64_t seq = storage->write_seq.load(std::memory_order_relaxed);
+        if (((seq + 1) >> 1) > _frame + storage->nslots) // writer started reusing the slot during the copy
+            return -1;
+        return 0;
+    }
+
+    inline int read_frame(SharedMemory &_memory, const uint64_t _frame, void *_dst)
+    {
+        // read_frame
+        //   copy a frame published through begin_write()/end_write() without taking the mutex.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const uint64_t _frame - frame index
+        //   void *_dst - destination of get_frame_size() bytes
+        // Return:
+        //   0 if the copy is intact, -1 if the frame is not written yet or its slot was overwritten.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        uint64_t seq = storage->write_seq.load(std::memory_order_acquire);
+        if (_frame >= (seq >> 1)) // not complete yet
+            return -1;
+        if (_frame < oldest_readable_frame(storage, seq)) // slot reused by a later frame
+            return -1;
+        return copy_frame(_memory, _frame, _dst);
+    }
+
+    inline int read_latest_frame(SharedMemory &_memory, void *_dst, uint64_t *_frame = nullptr)
+    {
+        // read_latest_frame
+        //   copy the latest complete frame without taking the mutex, retrying while the writer overwrites it.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   void *_dst - destination of get_frame_size() bytes
+        //   uint64_t *_frame - if not null receives the index of the copied frame
+        // Return:
+        //   0 if a frame was copied, -1 if no frame has been published yet.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        while (true)
+        {
+            uint64_t completed = storage->write_seq.load(std::memory_order_acquire) >> 1;
+            if (completed == 0)
+                return -1;
+            if (read_frame(_memory, completed - 1, _dst) == 0)
+            {
+                if (_frame != nullptr)
+                    *_frame = completed - 1;
+                return 0;
+            }
+        }
+    }
+
+    inline int register_reader(SharedMemory &_memory, ReaderCursor &_cursor)
+    {
+        // register_reader
+        //   take an entry of the reader table. the cursor starts at the next frame to be written, and under
+        //   SHMIO_BACKPRESSURE the writer will not reuse a slot until the reader released it with release_frames().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - reader cursor
+        // Return:
+        //   0 on success, -1 with errno set otherwise (EROFS on a read-only mapping, ENOSPC if the table is full).
+
+        if (_memory.flags & SHMIO_READONLY)
+        {
+            errno = EROFS;
+            return -1;
+        }
+        if (_cursor.reader != -1)
+            return 0;
+        SharedStorage *storage = get_storage_ptr(_memory);
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            for (int32_t i = 0; i < SHMIO_MAX_READERS; ++i)
+            {
+                ReaderEntry &entry = storage->readers[i];
+                ReaderState expected = ReaderState::FREE;
+                if (!entry.state.compare_exchange_strong(expected, ReaderState::CLAIMED, std::memory_order_acquire))
+                    continue;
+                uint64_t next = get_write_index(storage);
+                entry.pid.store(getpid(), std::memory_order_relaxed);
+                entry.consumed.store(next, std::memory_order_relaxed);
+                entry.heartbeat_ns.store(monotonic_ns(), std::memory_order_relaxed);
+                uint32_t epoch = entry.epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+                entry.state.store(ReaderState::ACTIVE, std::memory_order_seq_cst);
+                _cursor.next = next;
+                _cursor.reader = i;
+                _cursor.epoch = epoch;
+                return 0;
+            }
+            if (evict_dead_readers(storage) == 0) // table full, make room if a reader died
+                break;
+        }
+        errno = ENOSPC;
+        return -1;
+    }
+
+    inline ReaderEntry *get_reader_entry(SharedMemory &_memory, ReaderCursor &_cursor)
+    {
+        // get_reader_entry
+        //   get the reader table entry of a registered cursor. a cursor whose entry was evicted is unregistered.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - reader cursor
+        // Return:
+        //   ReaderEntry * entry, nullptr with errno EINVAL if not registered or ESTALE if the reader was evicted.
+
+        if (_cursor.reader == -1)
+        {
+            errno = EINVAL;
+            return nullptr;
+        }
+        ReaderEntry *entry = &get_storage_ptr(_memory)->readers[_cursor.reader];
+        if (entry->state.load(std::memory_order_acquire) != ReaderState::ACTIVE || entry->epoch.load(std::memory_order_relaxed) != _cursor.epoch)
+        {
+            _cursor.reader = -1;
+            errno = ESTALE;
+            return nullptr;
+        }
+        return entry;
+    }
+
+    inline int reader_heartbeat(SharedMemory &_memory, ReaderCursor &_cursor)
+    {
+        // reader_heartbeat
+        //   tell the writer the reader is alive. release_frames() does this too, so only idle readers of a stream with
+        //   a reader timeout need to call it.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - registered reader cursor
+        // Return:
+        //   0 on success, -1 with errno EINVAL if the cursor is not registered or ESTALE if it was evicted.
+
+        ReaderEntry *entry = get_reader_entry(_memory, _cursor);
+        if (entry == nullptr)
+            return -1;
+        entry->heartbeat_ns.store(monotonic_ns(), std::memory_order_relaxed);
+        return 0;
+    }
+
+    inline int release_frames(SharedMemory &_memory, ReaderCursor &_cursor)
+    {
+        // release_frames
+        //   let the writer reuse the slots of every frame below _cursor.next. called by read_next_frame() and
+        //   read_latest_frame() after each copy, and after acquire_next_frame() once the reader is done with the slot.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - registered reader cursor
+        // Return:
+        //   0 on success, -1 with errno EINVAL if the cursor is not registered or ESTALE if it was evicted.
+
+        ReaderEntry *entry = get_reader_entry(_memory, _cursor);
+        if (entry == nullptr)
+            return -1;
+        entry->consumed.store(_cursor.next, std::memory_order_release);
+        entry->heartbeat_ns.store(monotonic_ns(), std::memory_order_relaxed);
+        wake_writer(get_storage_ptr(_memory));
+        return 0;
+    }
+
+    inline int unregister_reader(SharedMemory &_memory, ReaderCursor &_cursor)
+    {
+        // unregister_reader
+        //   free the reader table entry of _cursor, releasing the writer.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - registered reader cursor
+        // Return:
+        //   0 on success, -1 with errno EINVAL if the cursor is not registered or ESTALE if it was already evicted.
+
+        ReaderEntry *entry = get_reader_entry(_memory, _cursor);
+        if (entry == nullptr)
+            return -1;
+        ReaderState expected = ReaderState::ACTIVE;
+        entry->state.compare_exchange_strong(expected, ReaderState::FREE, std::memory_order_release);
+        _cursor.reader = -1;
+        wake_writer(get_storage_ptr(_memory));
+        return 0;
+    }
+
+    inline uint64_t consume_frame(ReaderCursor &_cursor, const uint64_t _frame)
+    {
+        // consume_frame
+        //   record that _frame was consumed, counting the frames skipped since the previous one. for readers of a
+        //   single frame buffer, e.g. get_frame_count() - 1 after wait_for_response() or wait_for_frame().
+        // Parameters:
+        //   ReaderCursor &_cursor - reader cursor
+        //   const uint64_t _frame - frame index
+        // Return:
+        //   uint64_t number of frames skipped, 0 also if _frame was already consumed.
+
+        _cursor.last_skipped = 0;
+        _cursor.last_overruns = 0;
+        if (_frame < _cursor.next)
+            return 0;
+        _cursor.last_skipped = _frame - _cursor.next;
+        _cursor.skipped += _cursor.last_skipped;
+        _cursor.consumed += 1;
+        _cursor.next = _frame + 1;
+        return _cursor.last_skipped;
+    }
+
+    inline int read_next_frame(SharedMemory &_memory, ReaderCursor &_cursor, void *_dst)
+    {
+        // read_next_frame
+        //   copy the oldest frame not yet consumed by _cursor that is still held in the ring. frames the writer
+        //   already recycled are counted as skipped, copies torn by the writer reusing the slot are counted as
+        //   overruns and retried on a newer frame.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - reader cursor
+        //   void *_dst - destination of get_frame_size() bytes
+        // Return:
+        //   0 if a frame was copied (see _cursor.last_skipped / last_overruns), -1 with errno EAGAIN if no new frame
+        //   or if the only slot holding one is being overwritten.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        uint64_t overruns = 0;
+        while (true)
+        {
+            uint64_t seq = storage->write_seq.load(std::memory_order_acquire);
+            uint64_t completed = seq >> 1;
+            uint64_t frame = std::max(_cursor.next, oldest_readable_frame(storage, seq));
+            if (frame >= completed) // nothing new, or every unconsumed complete frame is being overwritten
+            {
+                _cursor.overruns += overruns;
+                _cursor.last_overruns = overruns;
+                _cursor.last_skipped = 0;
+                errno = EAGAIN;
+                return -1;
+            }
+            if (copy_frame(_memory, frame, _dst) == 0)
+            {
+                consume_frame(_cursor, frame);
+                _cursor.overruns += overruns;
+                _cursor.last_overruns = overruns;
+                if (_cursor.reader != -1)
+                    release_frames(_memory, _cursor);
+                return 0;
+            }
+            ++overruns;
+        }
+    }
+
+    inline int read_latest_frame(SharedMemory &_memory, ReaderCursor &_cursor, void *_dst)
+    {
+        // read_latest_frame
+        //   copy the latest complete frame if _cursor has not consumed it yet, counting every older unconsumed frame
+        //   as skipped and torn copies as overruns.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - reader cursor
+        //   void *_dst - destination of get_frame_size() bytes
+        // Return:
+        //   0 if a frame was copied (see _cursor.last_skipped / last_overruns), -1 with errno EAGAIN if no new frame
+        //   or if its slot is being overwritten.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        uint64_t overruns = 0;
+        while (true)
+        {
+            uint64_t seq = storage->write_seq.load(std::memory_order_acquire);
+            uint64_t completed = seq >> 1;
+            if (_cursor.next >= completed || completed - 1 < oldest_readable_frame(storage, seq))
+            {
+                _cursor.overruns += overruns;
+                _cursor.last_overruns = overruns;
+                _cursor.last_skipped = 0;
+                errno = EAGAIN;
+                return -1;
+            }
+            if (copy_frame(_memory, completed - 1, _dst) == 0)
+            {
+                consume_frame(_cursor, completed - 1);
+                _cursor.overruns += overruns;
+                _cursor.last_overruns = overruns;
+                if (_cursor.reader != -1)
+                    release_frames(_memory, _cursor);
+                return 0;
+            }
+            ++overruns;
+        }
+    }
+
+    inline const char *acquire_next_frame(SharedMemory &_memory, ReaderCursor &_cursor)
+    {
+        // acquire_next_frame
+        //   consume the oldest frame not yet consumed by _cursor in place, without copying it. the slot stays valid
+        //   until release_frames() only for a registered reader of a SHMIO_BACKPRESSURE stream.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   ReaderCursor &_cursor - reader cursor
+        // Return:
+        //   pointer to the slot of the frame, nullptr with errno EAGAIN if there is no new frame or if the only slot
+        //   holding one is being overwritten.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        uint64_t seq = storage->write_seq.load(std::memory_order_acquire);
+        uint64_t frame = std::max(_cursor.next, oldest_readable_frame(storage, seq));
+        if (frame >= (seq >> 1)) // nothing new, or every unconsumed complete frame is being overwritten
+        {
+            errno = EAGAIN;
+            return nullptr;
+        }
+        consume_frame(_cursor, frame);
+        return get_slot_ptr(_memory, frame);
+    }
+
+    template <typename T>
+    T *get_pixels_ptr_as(SharedMemory &_memory) // Templated pixel data access with type safety
+    {
+        SharedStorage *storage = get_storage_ptr(_memory);
+
+        // Basic type checking (could be expanded)
+        if constexpr (std::is_same_v<T, uint8_t>)
+        {
+            if (storage->dtype != DataType::UINT8)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, int8_t>)
+        {
+            if (storage->dtype != DataType::INT8)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, uint16_t>)
+        {
+            if (storage->dtype != DataType::UINT16)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, int16_t>)
+        {
+            if (storage->dtype != DataType::INT16)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, uint32_t>)
+        {
+            if (storage->dtype != DataType::UINT32)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, int32_t>)
+        {
+            if (storage->dtype != DataType::INT32)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, uint64_t>)
+        {
+            if (storage->dtype != DataType::UINT64)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, int64_t>)
+        {
+            if (storage->dtype != DataType::INT64)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, float>)
+        {
+            if (storage->dtype != DataType::FLOAT)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, double>)
+        {
+            if (storage->dtype != DataType::DOUBLE)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, complex_float>)
+        {
+            if (storage->dtype != DataType::COMPLEX_FLOAT)
+                return nullptr;
+        }
+        else if constexpr (std::is_same_v<T, complex_double>)
+        {
+            if (storage->dtype != DataType::COMPLEX_DOUBLE)
+                return nullptr;
+        }
+
+        return reinterpret_cast<T *>(_memory.data);
+    }
+
+    template <typename T>
+    inline std::span<T> get_pixels_as(SharedMemory &_memory)
+    {
+        SharedStorage *storage = get_storage_ptr(_memory);
+        T *pixels_ptr = get_pixels_ptr_as<T>(_memory);
+        if (!pixels_ptr)
+            return {};
+        return std::span<T>(pixels_ptr, storage->npx);
+    }
+
+    template <typename T>
+    inline std::span<T> get_slot_as(SharedMemory &_memory, const uint64_t _frame)
+    {
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (!get_pixels_ptr_as<T>(_memory))
+            return {};
+        return std::span<T>(reinterpret_cast<T *>(get_slot_ptr(_memory, _frame)), storage->npx);
+    }
+
+    inline int close_shared_memory(SharedMemory &_memory)
+    {
+        // close_shared_memory
+        //   Close an open shared memory.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        // Return:
+        //   0 if stream closed correctly.
+
+        close_notify(_memory);
+        if (_memory.base != nullptr)
+            munmap(_memory.base, _memory.size);
+        if (_memory.fd != -1)
+            close(_memory.fd);
+        // std::string path = shm_path(_memory.name);
+        // shm_unlink(path.c_str()); // TODO: remove the file
+
+        _memory.base = nullptr;
+        _memory.data = nullptr;
+        _memory.fd = -1;
+        _memory.size = 0;
+        _memory.flags = 0;
+        _memory.prefaulted = 0;
+
+        return 0;
+    }
+
+    inline int open_shared_memory_fd(const std::string &_name, const int _oflag)
+    {
+        // open_shared_memory_fd
+        //   open an existing shared memory, either a POSIX shared memory object or a file on hugetlbfs.
+        // Parameters:
+        //   const std::string &_name - name of the shared memory
+        //   const int _oflag - O_RDONLY or O_RDWR
+        // Return:
+        //   file descriptor, -1 if neither exists.
+
+        std::string path = shm_path(_name);
+        int fd = shm_open(path.c_str(), _oflag, 0);
+        if (fd == -1 && errno == ENOENT)
+        {
+            fd = open(hugetlbfs_path(_name).c_str(), _oflag | O_CLOEXEC);
+            if (fd == -1)
+                errno = ENOENT;
+        }
+        return fd;
+    }
+
+    inline bool shared_memory_exists(const char *_name)
+    {
+        // shared_memory_exists
+        //   Check if shared memory exists.
+        // Parameters:
+        //   const char* _name - name of the shared memory
+        // Return:
+        //   true if shared memory exists false otherwise
+        int fd = open_shared_memory_fd(_name, O_RDONLY);
+        if (fd == -1)
+        {
+            return false; // does not exist
+        }
+        close(fd);
+        return true; // exists
+    }
+
+    inline int prefault_shared_memory(SharedMemory &_memory, const uint32_t _flags)
+    {
+        // prefault_shared_memory
+        //   apply SHMIO_PREFAULT / SHMIO_MLOCK to a mapped shared memory so the real-time loop never takes a first-touch
+        //   page fault. the minor faults taken here are recorded in _memory.prefaulted.
+        // Parameters:
+        //   SharedMemory &_memory - mapped memory
+        //   const uint32_t _flags - mapping flags
+        // Return:
+        //   0 on success, -1 if the mapping could not be locked.
+
+        _memory.flags = _flags;
+        _memory.prefaulted = 0;
+        if (!(_flags & (SHMIO_PREFAULT | SHMIO_MLOCK)))
+            return 0;
+
+        struct rusage before, after;
+        getrusage(RUSAGE_THREAD, &before); // this thread only, faults of other threads must not count
+
+        bool populated = false;
+        char *base = reinterpret_cast<char *>(_memory.base);
+        if (_flags & SHMIO_READONLY)
+        {
+#ifdef MADV_POPULATE_READ
+            populated = madvise(_memory.base, _memory.size, MADV_POPULATE_READ) == 0;
+#endif
+            if (!populated) // older kernels, read every page
+            {
+                for (size_t offset = 0; offset < _memory.size; offset += SHMIO_PAGE_SIZE)
+                    __atomic_load_n(base + offset, __ATOMIC_RELAXED);
+            }
+        }
+        else
+        {
+#ifdef MADV_POPULATE_WRITE
+            populated = madvise(_memory.base, _memory.size, MADV_POPULATE_WRITE) == 0;
+#endif
+            if (!populated) // older kernels, touch every page without changing its content
+            {
+                for (size_t offset = 0; offset < _memory.size; offset += SHMIO_PAGE_SIZE)
+                    __atomic_fetch_add(base + offset, 0, __ATOMIC_RELAXED);
+            }
+        }
+
+        int ret = 0;
+        if (_flags & SHMIO_MLOCK)
+            ret = mlock(_memory.base, _memory.size);
+
+        if (ret == -1) // the caller unmaps the memory, leave nothing that describes the failed mapping
+        {
+            _memory.flags = 0;
+            return -1;
+        }
+
+        getrusage(RUSAGE_THREAD, &after);
+        _memory.prefaulted = after.ru_minflt - before.ru_minflt;
+        return 0;
+    }
+
+    inline long get_prefaulted(SharedMemory &_memory)
+    {
+        // get_prefaulted
+        //   get the number of minor faults taken up front by SHMIO_PREFAULT, i.e. the faults avoided later.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        // Return:
+        //   long number of minor faults.
+
+        return _memory.prefaulted;
+    }
+
+    inline uint64_t wait_for_frame_until(SharedMemory &_memory, const uint64_t _last_seen, const struct timespec *_deadline)
+    {
+        // wait_for_frame_until
+        //   wait until the frame counter is greater than _last_seen or _deadline passes. read-only mappings cannot
+        //   register as futex waiters, so they poll every SHMIO_POLL_INTERVAL_NS without writing to the segment.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        //   const uint64_t _last_seen - last frame counter seen by the caller
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   uint64_t current frame counter, not greater than _last_seen (errno ETIMEDOUT) if the deadline passed.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (!(_memory.flags & SHMIO_READONLY))
+            return wait_for_frame_until(storage, _last_seen, _deadline);
+
+        uint64_t deadline_ns = _deadline ? timespec_ns(*_deadline) : UINT64_MAX;
+        spin_wait(get_wait_policy(storage), [&]
+                  { return get_frame_count(storage) > _last_seen; },
+                  deadline_ns);
+        const struct timespec interval = {0, SHMIO_POLL_INTERVAL_NS};
+        uint64_t count;
+        while ((count = get_frame_count(storage)) <= _last_seen)
+        {
+            if (deadline_ns != UINT64_MAX && monotonic_ns() >= deadline_ns)
+            {
+                errno = ETIMEDOUT;
+                break;
+            }
+            nanosleep(&interval, nullptr);
+        }
+        return count;
+    }
+
+    inline uint64_t wait_for_frame_for(SharedMemory &_memory, const uint64_t _last_seen, const uint64_t _timeout_ns)
+    {
+        struct timespec deadline = monotonic_deadline(_timeout_ns);
+        return wait_for_frame_until(_memory, _last_seen, &deadline);
+    }
+
+    inline uint64_t wait_for_frame(SharedMemory &_memory, const uint64_t _last_seen)
+    {
+        return wait_for_frame_until(_memory, _last_seen, nullptr);
+    }
+
+    inline size_t collect_ready_frames(std::span<SharedMemory *const> _streams, std::span<const uint64_t> _last_seen, std::vector<size_t> &_ready)
+    {
+        // collect_ready_frames
+        //   collect the streams whose frame counter is greater than the matching _last_seen.
+        // Parameters:
+        //   std::span<SharedMemory *const> _streams - streams
+        //   std::span<const uint64_t> _last_seen - last frame counter seen on each stream
+        //   std::vector<size_t> &_ready - cleared, then filled with the indices of the ready streams
+        // Return:
+        //   size_t number of ready streams.
+
+        _ready.clear();
+        for (size_t i = 0; i < _streams.size(); ++i)
+            if (get_frame_count(get_storage_ptr(*_streams[i])) > _last_seen[i])
+                _ready.push_back(i);
+        return _ready.size();
+    }
+
+    inline long futex_waitv(std::span<SharedMemory *const> _streams, std::span<const uint32_t> _words, const struct timespec *_deadline)
+    {
+        // futex_waitv
+        //   park the calling thread until the frame_word of any stream differs from the matching _words entry.
+        // Parameters:
+        //   std::span<SharedMemory *const> _streams - streams, at most FUTEX_WAITV_MAX
+        //   std::span<const uint32_t> _words - expected frame_word of each stream
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   index of a woken stream, -1 with errno set otherwise (ENOSYS without futex_waitv, ETIMEDOUT on deadline).
+
+#if defined(SYS_futex_waitv) && defined(FUTEX_WAITV_MAX)
+        struct futex_waitv waiters[FUTEX_WAITV_MAX];
+        std::memset(waiters, 0, sizeof(waiters));
+        for (size_t i = 0; i < _streams.size(); ++i)
+        {
+            waiters[i].val = _words[i];
+            waiters[i].uaddr = reinterpret_cast<uintptr_t>(&get_storage_ptr(*_streams[i])->frame_word);
+            waiters[i].flags = FUTEX_32; // shared futex, the segment is mapped by several processes
+        }
+        return syscall(SYS_futex_waitv, waiters, static_cast<unsigned int>(_streams.size()), 0, _deadline, CLOCK_MONOTONIC);
+#else
+        (void)_streams;
+        (void)_words;
+        (void)_deadline;
+        errno = ENOSYS;
+        return -1;
+#endif
+    }
+
+    inline int wait_for_any_frame_until(std::span<SharedMemory *const> _streams, std::span<const uint64_t> _last_seen, std::vector<size_t> &_ready, const struct timespec *_deadline)
+    {
+        // wait_for_any_frame_until
+        //   wait until at least one stream has a frame counter greater than the matching _last_seen, or _deadline
+        //   passes. blocks in a single futex_waitv() on every frame_word; falls back to polling every
+        //   SHMIO_POLL_INTERVAL_NS if futex_waitv is unavailable, there are more than FUTEX_WAITV_MAX streams or a
+        //   stream is mapped SHMIO_READONLY.
+        // Parameters:
+        //   std::span<SharedMemory *const> _streams - streams
+        //   std::span<const uint64_t> _last_seen - last frame counter seen on each stream
+        //   std::vector<size_t> &_ready - filled with the indices of the ready streams
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   number of ready streams, -1 with errno set otherwise (ETIMEDOUT, EINVAL if the spans differ in size).
+
+        if (_streams.size() != _last_seen.size() || _streams.empty())
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        if (collect_ready_frames(_streams, _last_seen, _ready) > 0)
+            return static_cast<int>(_ready.size());
+
+        bool poll = true;
+#if defined(SYS_futex_waitv) && defined(FUTEX_WAITV_MAX)
+        poll = _streams.size() > FUTEX_WAITV_MAX;
+        for (SharedMemory *stream : _streams)
+            poll = poll || (stream->flags & SHMIO_READONLY);
+        std::vector<uint32_t> words(_streams.size());
+        while (!poll)
+        {
+            for (size_t i = 0; i < _streams.size(); ++i) // same protocol as wait_for_frame_until(), on every stream
+            {
+                SharedStorage *storage = get_storage_ptr(*_streams[i]);
+                storage->frame_waiters.fetch_add(1, std::memory_order_seq_cst);
+                words[i] = storage->frame_word.load(std::memory_order_seq_cst);
+            }
+            long ret = 0;
+            if (collect_ready_frames(_streams, _last_seen, _ready) == 0) // publish_frame() bumps the word after the counter
+                ret = futex_waitv(_streams, words, _deadline);
+            int err = errno;
+            for (SharedMemory *stream : _streams)
+                get_storage_ptr(*stream)->frame_waiters.fetch_sub(1, std::memory_order_relaxed);
+            if (collect_ready_frames(_streams, _last_seen, _ready) > 0)
+                return static_cast<int>(_ready.size());
+            if (ret == -1 && err == ETIMEDOUT)
+            {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            poll = ret == -1 && err == ENOSYS;
+        }
+#endif
+
+        uint64_t deadline_ns = _deadline ? timespec_ns(*_deadline) : UINT64_MAX;
+        const struct timespec interval = {0, SHMIO_POLL_INTERVAL_NS};
+        while (collect_ready_frames(_streams, _last_seen, _ready) == 0)
+        {
+            if (deadline_ns != UINT64_MAX && monotonic_ns() >= deadline_ns)
+            {
+                errno = ETIMEDOUT;
+                return -1;
+            }
+            nanosleep(&interval, nullptr);
+        }
+        return static_cast<int>(_ready.size());
+    }
+
+    inline int wait_for_any_frame(std::span<SharedMemory *const> _streams, std::span<const uint64_t> _last_seen, std::vector<size_t> &_ready)
+    {
+        return wait_for_any_frame_until(_streams, _last_seen, _ready, nullptr);
+    }
+
+    inline int wait_for_all_frames_until(std::span<SharedMemory *const> _streams, std::span<const uint64_t> _last_seen, std::vector<size_t> &_ready, const struct timespec *_deadline)
+    {
+        // wait_for_all_frames_until
+        //   wait until every stream has a frame counter greater than the matching _last_seen, or _deadline passes.
+        //   frame counters never decrease, so the streams are waited on one after the other.
+        // Parameters:
+        //   std::span<SharedMemory *const> _streams - streams
+        //   std::span<const uint64_t> _last_seen - last frame counter seen on each stream
+        //   std::vector<size_t> &_ready - filled with the indices of the ready streams, all of them on success
+        // Return:
+        //   number of streams, -1 with errno set otherwise (ETIMEDOUT, EINVAL if the spans differ in size).
+
+        if (_streams.size() != _last_seen.size())
+        {
+            errno = EINVAL;
+            return -1;
+        }
+        for (size_t i = 0; i < _streams.size(); ++i)
+        {
+            if (wait_for_frame_until(*_streams[i], _last_seen[i], _deadline) <= _last_seen[i])
+            {
+                collect_ready_frames(_streams, _last_seen, _ready);
+                errno = ETIMEDOUT;
+                return -1;
+            }
+        }
+        return static_cast<int>(collect_ready_frames(_streams, _last_seen, _ready));
+    }
+
+    inline int wait_for_all_frames(std::span<SharedMemory *const> _streams, std::span<const uint64_t> _last_seen, std::vector<size_t> &_ready)
+    {
+        return wait_for_all_frames_until(_streams, _last_seen, _ready, nullptr);
+    }
+
+    inline bool valid_layout(SharedMemory &_memory)
+    {
+        // valid_layout
+        //   check that a mapped shared memory uses this layout version and that its size matches its header.
+        // Parameters:
+        //   SharedMemory &_memory - memory mapped over at least sizeof(SharedStorage) bytes
+        // Return:
+        //   true if the layout is valid false otherwise
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (std::atomic_ref<uint64_t>(storage->magic).load(std::memory_order_acquire) != SHMIO_MAGIC || storage->version != SHMIO_LAYOUT_VERSION || storage->nslots == 0)
+            return false;
+        SharedLayout layout = shared_memory_layout(storage->nkw, storage->npx, storage->dtype, storage->nslots, storage->flags);
+        return layout.size == _memory.size && layout.alignment == storage->alignment && layout.values_offset == storage->values_offset &&
+               layout.keywords_offset == storage->keywords_offset &&
+               layout.index_offset == storage->index_offset && layout.pixels_offset == storage->pixels_offset && layout.slot_stride == storage->slot_stride;
+    }
+
+    inline int setup_open_shared_memory(SharedMemory &_memory, const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords, const size_t _nslots = 1, const uint32_t _flags = 0)
+    {
+        // setup_open_shared_memory
+        //   setup a shared memory. if a shared memory by that name exists an attempt will be made to use it. the existing
+        //   schema must match, live keyword values are left untouched.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        //   const char *_name - filename
+        //   const size_t _npx - number of pixels
+        //   const DataType _dtype - type of pixels
+        //   const std::vector<Keyword> &_keywords - keywords
+        //   const size_t _nslots - number of frame slots
+        //   const uint32_t _flags - mapping flags (SHMIO_PREFAULT, SHMIO_MLOCK, SHMIO_READONLY)
+        // Return:
+        //   0 if stream is created correctly. leaves the stream open.
+
+        if (_memory.name.empty())
+        {
+            return -1;
+        }
+
+        bool readonly = (_flags & SHMIO_READONLY) != 0;
+        _memory.fd = open_shared_memory_fd(_memory.name, readonly ? O_RDONLY : O_RDWR); // Open existing shared memory object
+        if (_memory.fd == -1)
+        {
+            return -1;
+        }
+
+        struct stat file_stat;
+        if (fstat(_memory.fd, &file_stat) == -1) // Get the size of the shared memory object
+        {
+            close(_memory.fd);
+            _memory.fd = -1;
+            return -1;
+        }
+
+        size_t file_size = static_cast<size_t>(file_stat.st_size);
+        if (file_size < sizeof(SharedStorage))
+        {
+            close(_memory.fd);
+            _memory.fd = -1;
+            return -1;
+        }
+
+        _memory.size = file_size;
+        _memory.base = map_shared_memory(_memory.fd, _memory.size, readonly ? PROT_READ : PROT_READ | PROT_WRITE);
+        if (_memory.base == MAP_FAILED)
+        {
+            _memory.base = nullptr;
+            close(_memory.fd);
+            _memory.fd = -1;
+            _memory.size = 0;
+            return -1;
+        }
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (!valid_layout(_memory) || storage->nkw != _keywords.size() || storage->npx != _npx || storage->dtype != _dtype || storage->nslots != _nslots)
+        {
+            munmap(_memory.base, _memory.size);
+            _memory.base = nullptr;
+            close(_memory.fd);
+            _memory.fd = -1;
+            _memory.size = 0;
+            return -1;
+        }
+
+        if (storage->flags & SHMIO_HUGEPAGES)
+            madvise(_memory.base, _memory.size, MADV_HUGEPAGE); // no-op on hugetlbfs, requests THP on shmem
+
+        if (!readonly)
+            update_last_access_time(storage);
+
+        if (storage->schema_hash != schema_hash(_npx, _dtype, _keywords)) // fingerprint mismatch, find the offending keyword
+        {
+            KeywordList keywords = get_keywords(_memory);
+            for (size_t ikw = 0; ikw < storage->nkw && ikw < _keywords.size(); ++ikw)
+            {
+                if (std::strncmp(keywords[ikw].name(), _keywords[ikw].name, KEYWORD_MAX_STRING) != 0)
+                {
+                    // kato::log::cout << KATO_RED << "setup_open_shared_memory() - keyword " << ikw << "name not matching." << KATO_RESET << std::endl;
+                    munmap(_memory.base, _memory.size);
+                    _memory.base = nullptr;
+                    close(_memory.fd);
+                    _memory.fd = -1;
+                    _memory.size = 0;
+                    return -1;
+                }
+                else if (std::strncmp(keywords[ikw].comment(), _keywords[ikw].comment, KEYWORD_MAX_COMMENT) != 0)
+                {
+                    // kato::log::cout << KATO_RED << "setup_open_shared_memory() - keyword " << ikw << "comment not matching." << KATO_RESET << std::endl;
+                    munmap(_memory.base, _memory.size);
+                    _memory.base = nullptr;
+                    close(_memory.fd);
+                    _memory.fd = -1;
+                    _memory.size = 0;
+                    return -1;
+                }
+                else if (keywords[ikw].meta->type != _keywords[ikw].type)
+                {
+                    // kato::log::cout << KATO_RED << "setup_open_shared_memory() - keyword " << ikw << "type not matching." << KATO_RESET << std::endl;
+                    munmap(_memory.base, _memory.size);
+                    _memory.base = nullptr;
+                    close(_memory.fd);
+                    _memory.fd = -1;
+                    _memory.size = 0;
+                    return -1;
+                }
+            }
+        }
+
+        if (prefault_shared_memory(_memory, _flags) == -1)
+        {
+            int err = errno;
+            munmap(_memory.base, _memory.size);
+            _memory.base = nullptr;
+            close(_memory.fd);
+            _memory.fd = -1;
+            _memory.size = 0;
+            errno = err;
+            return -1;
+        }
+
+        _memory.data = get_pixels_ptr(_memory);
+
+        return 0;
+    }
+
+    inline int setup_open_shared_memory(SharedMemory &_memory, const uint32_t _flags = 0)
+    {
+        // setup_open_shared_memory
+        //   setup a shared memory.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        //   const uint32_t _flags - mapping flags (SHMIO_PREFAULT, SHMIO_MLOCK, SHMIO_READONLY)
+        // Return:
+        //   0 if shared memory is setup correctly otherwise the shared memory will be closed gracefully.
+
+        if (_memory.name.empty())
+        {
+            return -1;
+        }
+
+        bool readonly = (_flags & SHMIO_READONLY) != 0;
+        _memory.fd = open_shared_memory_fd(_memory.name, readonly ? O_RDONLY : O_RDWR); // Open existing shared memory object
+        if (_memory.fd == -1)
+        {
+            return -1;
+        }
+
+        struct stat file_stat;
+        if (fstat(_memory.fd, &file_stat) == -1) // Get the size of the shared memory object
+        {
+            close(_memory.fd);
+            _memory.fd = -1;
+            return -1;
+        }
+
+        size_t file_size = static_cast<size_t>(file_stat.st_size);
+        if (file_size < sizeof(SharedStorage))
+        {
+            close(_memory.fd);
+            _memory.fd = -1;
+            return -1;
+        }
+
+        _memory.size = file_size;
+        _memory.base = map_shared_memory(_memory.fd, _memory.size, readonly ? PROT_READ : PROT_READ | PROT_WRITE);
+        if (_memory.base == MAP_FAILED)
+        {
+            _memory.base = nullptr;
+            close(_memory.fd);
+            _memory.fd = -1;
+            _memory.size = 0;
+            return -1;
+        }
+
+        if (!valid_layout(_memory))
+        {
+            munmap(_memory.base, _memory.size);
+            _memory.base = nullptr;
+            close(_memory.fd);
+            _memory.fd = -1;
+            _memory.size = 0;
+            return -1;
+        }
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (storage->flags & SHMIO_HUGEPAGES)
+            madvise(_memory.base, _memory.size, MADV_HUGEPAGE); // no-op on hugetlbfs, requests THP on shmem
+
+        if (!readonly)
+            update_last_access_time(storage);
+
+        if (prefault_shared_memory(_memory, _flags) == -1)
+        {
+            int err = errno;
+            munmap(_memory.base, _memory.size);
+            _memory.base = nullptr;
+            close(_memory.fd);
+            _memory.fd = -1;
+            _memory.size = 0;
+            errno = err;
+            return -1;
+        }
+
+        _memory.data = get_pixels_ptr(_memory);
+
+        return 0;
+    }
+
+    inline bool shm_backing_exists(const std::string &_name)
+    {
+        // shm_backing_exists
+        //   check if a POSIX shared memory object backs the shared memory _name.
+        // Parameters:
+        //   const std::string &_name - name of the shared memory
+        // Return:
+        //   true if it exists.
+
+        int fd = shm_open(shm_path(_name).c_str(), O_RDONLY, 0);
+        if (fd == -1)
+            return errno != ENOENT;
+        close(fd);
+        return true;
+    }
+
+    inline bool hugetlbfs_backing_exists(const std::string &_name)
+    {
+        // hugetlbfs_backing_exists
+        //   check if a file on hugetlbfs backs the shared memory _name.
+        // Parameters:
+        //   const std::string &_name - name of the shared memory
+        // Return:
+        //   true if it exists.
+
+        return access(hugetlbfs_path(_name).c_str(), F_OK) == 0;
+    }
+
+    inline int create_hugetlbfs_memory(SharedMemory &_memory)
+    {
+        // create_hugetlbfs_memory
+        //   create and map a shared memory of _memory.size bytes on hugetlbfs. openers find it by name through
+        //   open_shared_memory_fd().
+        // Parameters:
+        //   SharedMemory &_memory - memory, name and size set
+        // Return:
+        //   0 if the shared memory is created and mapped, -1 otherwise (errno EEXIST if the name is taken).
+
+        std::string path = hugetlbfs_path(_memory.name);
+        _memory.fd = open(path.c_str(), O_CREAT | O_EXCL | O_RDWR | O_CLOEXEC, 0600);
+        if (_memory.fd < 0)
+        {
+            return -1;
+        }
+
+        if (shm_backing_exists(_memory.name)) // checked after the exclusive create, so two creators cannot both miss each other
+        {
+            close(_memory.fd);
+            unlink(path.c_str());
+            _memory.fd = -1;
+            errno = EEXIST;
+            return -1;
+        }
+
+        if (ftruncate(_memory.fd, _memory.size) == -1)
+        {
+            close(_memory.fd);
+            unlink(path.c_str());
+            _memory.fd = -1;
+            return -1;
+        }
+
+        _memory.base = map_shared_memory(_memory.fd, _memory.size, PROT_READ | PROT_WRITE); // fails if the huge page pool is too small
+        if (_memory.base == MAP_FAILED)
+        {
+            _memory.base = nullptr;
+            close(_memory.fd);
+            unlink(path.c_str());
+            _memory.fd = -1;
+            return -1;
+        }
+
+        return 0;
+    }
+
+    inline void remove_created_memory(SharedMemory &_memory, const bool _hugetlbfs)
+    {
+        // remove_created_memory
+        //   undo a create that failed after the backing was created: unmap and close it, then remove its name.
+        // Parameters:
+        //   SharedMemory &_memory - memory, name set
+        //   const bool _hugetlbfs - true if the backing is a file on hugetlbfs, false for a POSIX shared memory object
+
+        if (_memory.base != nullptr)
+            munmap(_memory.base, _memory.size);
+        if (_memory.fd != -1)
+            close(_memory.fd);
+        if (_hugetlbfs)
+            unlink(hugetlbfs_path(_memory.name).c_str());
+        else
+            shm_unlink(shm_path(_memory.name).c_str());
+        _memory.base = nullptr;
+        _memory.fd = -1;
+        _memory.size = 0;
+    }
+
+    inline int create_open_shared_memory(SharedMemory &_memory, const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords, const size_t _nslots = 1, const uint32_t _flags = 0)
+    {
+        // create_open_shared_memory
+        //   create a shared memory. if a shared memory by that name exists an attempt will be made to use it.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        //   const char *_name - filename
+        //   const size_t _npx - number of pixels
+        //   const DataType _dtype - type of pixels
+        //   const std::vector<Keyword> &_keywords - keywords
+        //   const size_t _nslots - number of frame slots, 1 for a single frame buffer
+        //   const uint32_t _flags - creation flags (SHMIO_*)
+        // Return:
+        //   0 if stream is created correctly. leaves the stream open.
+
+        if (_memory.name.empty() || _nslots == 0)
+        {
+            return -1;
+        }
+
+        if (_flags & SHMIO_READONLY) // a creator has to initialize the segment
+        {
+            errno = EINVAL;
+            return -1;
+        }
+
+        SharedLayout layout = shared_memory_layout(_keywords.size(), _npx, _dtype, _nslots, _flags);
+        _memory.size = layout.size;
+
+        bool hugetlbfs = false;
+        if (_flags & SHMIO_HUGEPAGES)
+        {
+            if (create_hugetlbfs_memory(_memory) == 0)
+                hugetlbfs = true;
+            else if (errno == EEXIST)
+                return -1;
+        }
+
+        if (_memory.base == nullptr)
+        {
+            std::string path = shm_path(_memory.name);
+            _memory.fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+            if (_memory.fd < 0)
+            {
+                return -1;
+            }
+
+            if (hugetlbfs_backing_exists(_memory.name)) // checked after the exclusive create, so two creators cannot both miss each other
+            {
+                remove_created_memory(_memory, false);
+                errno = EEXIST;
+                return -1;
+            }
+
+            if (ftruncate(_memory.fd, _memory.size) == -1)
+            {
+                int err = errno;
+                remove_created_memory(_memory, false);
+                errno = err;
+                return -1;
+            }
+
+            _memory.base = map_shared_memory(_memory.fd, _memory.size, PROT_READ | PROT_WRITE);
+            if (_memory.base == MAP_FAILED)
+            {
+                int err = errno;
+                _memory.base = nullptr;
+                remove_created_memory(_memory, false);
+                errno = err;
+                return -1;
+            }
+
+            if (_flags & SHMIO_HUGEPAGES) // no hugetlbfs, ask for transparent huge pages on shmem
+                madvise(_memory.base, _memory.size, MADV_HUGEPAGE);
+        }
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+
+        // Initialize mutex (only once, by creator)
+        pthread_mutexattr_t mattr;
+        pthread_mutexattr_init(&mattr);
+        pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
+        pthread_mutexattr_setrobust(&mattr, PTHREAD_MUTEX_ROBUST); // a process dying with the lock does not deadlock the stream
+        if (_flags & SHMIO_PRIO_INHERIT) // a low-priority owner runs at the priority of the highest waiter (PI futex)
+            pthread_mutexattr_setprotocol(&mattr, PTHREAD_PRIO_INHERIT);
+        int err = pthread_mutex_init(&storage->mutex, &mattr);
+        pthread_mutexattr_destroy(&mattr);
+        if (err != 0) // e.g. no PI futex support
+        {
+            remove_created_memory(_memory, hugetlbfs);
+            errno = err;
             return -1;
         }
 
-        struct stat file_stat;
-        if (fstat(_memory.fd, &file_stat) == -1) // Get the size of the shared memory object
+        pthread_condattr_t cattr;
+        pthread_condattr_init(&cattr);
+        pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
+        pthread_condattr_setclock(&cattr, CLOCK_MONOTONIC); // timed waits must not follow wall clock steps
+        pthread_cond_init(&storage->has_request_cond, &cattr);
+        pthread_cond_init(&storage->has_response_cond, &cattr);
+        pthread_condattr_destroy(&cattr);
+
+        clock_gettime(CLOCK_REALTIME, &storage->creationtime);
+        store_timespec(storage->lastaccesstime, storage->creationtime);
+        storage->version = SHMIO_LAYOUT_VERSION;
+        storage->schema_hash = schema_hash(_npx, _dtype, _keywords);
+        storage->nkw = _keywords.size();
+        storage->npx = _npx;
+        storage->dtype = _dtype;
+        storage->nslots = _nslots;
+        storage->alignment = layout.alignment;
+        storage->values_offset = layout.values_offset;
+        storage->keywords_offset = layout.keywords_offset;
+        storage->index_offset = layout.index_offset;
+        storage->pixels_offset = layout.pixels_offset;
+        storage->slot_stride = layout.slot_stride;
+        storage->write_index.store(0, std::memory_order_relaxed);
+        storage->write_seq.store(0, std::memory_order_relaxed);
+        storage->flags = _flags;
+        storage->has_request.store(0, std::memory_order_relaxed);
+        storage->request_waiters.store(0, std::memory_order_relaxed);
+        storage->has_response.store(0, std::memory_order_relaxed);
+        storage->response_waiters.store(0, std::memory_order_relaxed);
+        storage->frame_count.store(0, std::memory_order_relaxed);
+        storage->response_index.store(0, std::memory_order_relaxed);
+        storage->frame_word.store(0, std::memory_order_relaxed);
+        storage->info_seq.store(0, std::memory_order_relaxed);
+        storage->info_frame.store(0, std::memory_order_relaxed);
+        storage->info_monotonic_ns.store(0, std::memory_order_relaxed);
+        storage->info_realtime_ns.store(0, std::memory_order_relaxed);
+        storage->frame_waiters.store(0, std::memory_order_relaxed);
+        storage->notify_generation.store(0, std::memory_order_relaxed);
+        storage->release_word.store(0, std::memory_order_relaxed);
+        storage->release_waiters.store(0, std::memory_order_relaxed);
+        for (ReaderEntry &entry : storage->readers)
         {
-            close(_memory.fd);
-            _memory.fd = -1;
+            entry.state.store(ReaderState::FREE, std::memory_order_relaxed);
+            entry.pid.store(0, std::memory_order_relaxed);
+            entry.consumed.store(0, std::memory_order_relaxed);
+            entry.heartbeat_ns.store(0, std::memory_order_relaxed);
+            entry.epoch.store(0, std::memory_order_relaxed);
+        }
+        storage->reader_timeout_ns = 0;
+        storage->queue_tail.store(0, std::memory_order_relaxed);
+        storage->queue_request_word.store(0, std::memory_order_relaxed);
+        storage->queue_request_waiters.store(0, std::memory_order_relaxed);
+        storage->queue_head.store(0, std::memory_order_relaxed);
+        storage->queue_response_word.store(0, std::memory_order_relaxed);
+        storage->queue_response_waiters.store(0, std::memory_order_relaxed);
+        storage->coalesce_state.store(0, std::memory_order_relaxed);
+        storage->coalesce_request_word.store(0, std::memory_order_relaxed);
+        storage->coalesce_request_waiters.store(0, std::memory_order_relaxed);
+        storage->coalesce_served.store(0, std::memory_order_relaxed);
+        storage->coalesce_served_waiters.store(0, std::memory_order_relaxed);
+        for (uint64_t i = 0; i < SHMIO_REQUEST_QUEUE_SIZE; ++i)
+        {
+            storage->queue[i].seq.store(i, std::memory_order_relaxed);
+            storage->queue[i].argument.store(0, std::memory_order_relaxed);
+            storage->queue[i].result.store(0, std::memory_order_relaxed);
+            storage->queue[i].pid.store(0, std::memory_order_relaxed);
+            storage->queue[i].responder.store(0, std::memory_order_relaxed);
+        }
+        storage->keywords_seq.store(0, std::memory_order_relaxed);
+
+        char *base = reinterpret_cast<char *>(get_keywords_ptr(_memory));
+        std::memcpy(base, _keywords.data(), _keywords.size() * sizeof(Keyword));
+        KeywordValue *values = get_keyword_values_ptr(_memory);
+        for (size_t ikw = 0; ikw < _keywords.size(); ++ikw)
+            values[ikw] = KeywordValue{_keywords[ikw].type, 0, _keywords[ikw].value};
+        build_keyword_index(_memory);
+        std::atomic_ref<uint64_t>(storage->magic).store(SHMIO_MAGIC, std::memory_order_release); // publish the segment, openers acquire it in valid_layout()
+
+        if (prefault_shared_memory(_memory, _flags) == -1) // the segment is already published, remove it so no one opens it
+        {
+            int err = errno;
+            remove_created_memory(_memory, hugetlbfs);
+            errno = err;
+            return -1;
+        }
+
+        _memory.data = get_pixels_ptr(_memory);
+
+        return 0;
+    };
+
+    inline int create_open_shared_memory(SharedMemory &_memory, const char *_name, const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords, const size_t _nslots = 1, const uint32_t _flags = 0)
+    {
+        // create_open_shared_memory
+        //   Create an opened shared memory. if a shared memory by that name exists an attempt will be made to use it.
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        //   const char *_name - filename
+        //   const size_t _npx - number of pixels
+        //   const DataType _dtype - type of pixels
+        //   const std::vector<Keyword> &_keywords - keywords
+        //   const size_t _nslots - number of frame slots, 1 for a single frame buffer
+        //   const uint32_t _flags - creation flags (SHMIO_*), only the mapping flags apply if the shared memory already exists
+        // Return:
+        //   0 if stream is created correctly. leaves the stream open.
+
+        _memory.name = _name;
+        int ret = create_open_shared_memory(_memory, _npx, _dtype, _keywords, _nslots, _flags);
+        if (ret == -1 && errno == EEXIST)
+            return setup_open_shared_memory(_memory, _npx, _dtype, _keywords, _nslots, _flags);
+        return ret;
+    }
+
+    inline int open_shared_memory(SharedMemory &_memory, const char *_name, const uint32_t _flags = 0)
+    {
+        // open_shared_memory
+        //   open a shared memory by name
+        // Parameters:
+        //   SharedMemory &_memory - memory
+        //   const std::string _name - filename
+        //   const uint32_t _flags - mapping flags (SHMIO_PREFAULT, SHMIO_MLOCK, SHMIO_READONLY)
+        // Return:
+        //   0 if stream is created correctly. leaves the stream open.
+
+        _memory.name = _name;
+        return setup_open_shared_memory(_memory, _flags);
+    }
+
+    inline KeywordRef find_keyword(SharedMemory &_memory, const char *name) // Find keyword by name
+    {
+        return get_keyword(_memory, find_keyword_handle(_memory, name));
+    }
+
+    inline KeywordValue *get_keyword_value(SharedMemory &_memory, const KeywordHandle _handle, const KeywordType _type)
+    {
+        // get_keyword_value
+        //   get the hot value of a keyword, checking the handle and the type.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        //   const KeywordType _type - expected type
+        // Return:
+        //   KeywordValue pointer, nullptr if the handle is invalid or the type does not match.
+
+        if (_handle >= get_storage_ptr(_memory)->nkw)
+            return nullptr;
+        KeywordValue *value = get_keyword_values_ptr(_memory) + _handle;
+        if (value->type != _type)
+            return nullptr;
+        return value;
+    }
+
+    inline int set_keyword_long(SharedMemory &_memory, const KeywordHandle _handle, const int64_t _value)
+    {
+        // set_keyword_long
+        //   atomically update a LONG keyword without taking the stream mutex.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        //   const int64_t _value - new value
+        // Return:
+        //   0 on success, -1 if the handle is invalid or the keyword is not a LONG.
+
+        KeywordValue *value = get_keyword_value(_memory, _handle, KeywordType::LONG);
+        if (value == nullptr)
+            return -1;
+        std::atomic_ref<int64_t>(value->value.numl).store(_value, std::memory_order_release);
+        std::atomic_ref<uint32_t>(value->version).fetch_add(1, std::memory_order_release); // readers acquiring the version see the value
+        return 0;
+    }
+
+    inline int set_keyword_double(SharedMemory &_memory, const KeywordHandle _handle, const double _value)
+    {
+        // set_keyword_double
+        //   atomically update a DOUBLE keyword without taking the stream mutex.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        //   const double _value - new value
+        // Return:
+        //   0 on success, -1 if the handle is invalid or the keyword is not a DOUBLE.
+
+        KeywordValue *value = get_keyword_value(_memory, _handle, KeywordType::DOUBLE);
+        if (value == nullptr)
+            return -1;
+        std::atomic_ref<double>(value->value.numf).store(_value, std::memory_order_release);
+        std::atomic_ref<uint32_t>(value->version).fetch_add(1, std::memory_order_release); // readers acquiring the version see the value
+        return 0;
+    }
+
+    inline int get_keyword_long(SharedMemory &_memory, const KeywordHandle _handle, int64_t &_value)
+    {
+        // get_keyword_long
+        //   atomically read a LONG keyword.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        //   int64_t &_value - receives the value
+        // Return:
+        //   0 on success, -1 if the handle is invalid or the keyword is not a LONG.
+
+        KeywordValue *value = get_keyword_value(_memory, _handle, KeywordType::LONG);
+        if (value == nullptr)
+            return -1;
+        _value = std::atomic_ref<int64_t>(value->value.numl).load(std::memory_order_acquire);
+        return 0;
+    }
+
+    inline int get_keyword_double(SharedMemory &_memory, const KeywordHandle _handle, double &_value)
+    {
+        // get_keyword_double
+        //   atomically read a DOUBLE keyword.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        //   double &_value - receives the value
+        // Return:
+        //   0 on success, -1 if the handle is invalid or the keyword is not a DOUBLE.
+
+        KeywordValue *value = get_keyword_value(_memory, _handle, KeywordType::DOUBLE);
+        if (value == nullptr)
+            return -1;
+        _value = std::atomic_ref<double>(value->value.numf).load(std::memory_order_acquire);
+        return 0;
+    }
+
+    inline int write_keywords(SharedMemory &_memory, std::span<const KeywordHandle> _handles, std::span<const KeywordData> _values)
+    {
+        // write_keywords
+        //   publish a set of keyword values atomically with respect to read_keywords(). concurrent batches are serialized.
+        //   single set_keyword_*() calls are not ordered against batches.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   std::span<const KeywordHandle> _handles - keyword handles
+        //   std::span<const KeywordData> _values - new values, one per handle
+        // Return:
+        //   0 on success, -1 if the spans differ in size or a handle is invalid.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (_handles.size() != _values.size())
+            return -1;
+        for (KeywordHandle handle : _handles)
+            if (handle >= storage->nkw)
+                return -1;
+
+        uint64_t seq = storage->keywords_seq.load(std::memory_order_relaxed);
+        while ((seq & 1) || !storage->keywords_seq.compare_exchange_weak(seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed))
+        {
+            cpu_relax();
+            seq = storage->keywords_seq.load(std::memory_order_relaxed);
+        }
+        KeywordValue *values = get_keyword_values_ptr(_memory);
+        for (size_t i = 0; i < _handles.size(); ++i)
+        {
+            int64_t bits;
+            std::memcpy(&bits, &_values[i], sizeof(bits));
+            std::atomic_ref<int64_t>(values[_handles[i]].value.numl).store(bits, std::memory_order_release); // a reader that sees the value sees the odd sequence
+            std::atomic_ref<uint32_t>(values[_handles[i]].version).fetch_add(1, std::memory_order_relaxed);
+        }
+
+        storage->keywords_seq.store(seq + 2, std::memory_order_release);
+        return 0;
+    }
+
+    inline int read_keywords(SharedMemory &_memory, std::span<const KeywordHandle> _handles, std::span<KeywordData> _values)
+    {
+        // read_keywords
+        //   read a set of keyword values as one consistent snapshot, retrying while a write_keywords() batch is in
+        //   progress. every load is an acquire load, a plain load on x86.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   std::span<const KeywordHandle> _handles - keyword handles
+        //   std::span<KeywordData> _values - receives the values, one per handle
+        // Return:
+        //   0 on success, -1 if the spans differ in size or a handle is invalid.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        if (_handles.size() != _values.size())
             return -1;
+        for (KeywordHandle handle : _handles)
+            if (handle >= storage->nkw)
+                return -1;
+
+        KeywordValue *values = get_keyword_values_ptr(_memory);
+        while (true)
+        {
+            uint64_t seq = storage->keywords_seq.load(std::memory_order_acquire);
+            if (seq & 1)
+            {
+                cpu_relax();
+                continue;
+            }
+            for (size_t i = 0; i < _handles.size(); ++i)
+            {
+                int64_t bits = std::atomic_ref<int64_t>(values[_handles[i]].value.numl).load(std::memory_order_acquire); // orders the sequence check after the load
+                std::memcpy(&_values[i], &bits, sizeof(bits));
+            }
+            if (storage->keywords_seq.load(std::memory_order_relaxed) == seq)
+                return 0;
+        }
+    }
+
+    inline uint32_t get_keyword_version(SharedMemory &_memory, const KeywordHandle _handle)
+    {
+        // get_keyword_version
+        //   get the version counter of a keyword. it changes whenever a set_keyword_*() call updates the value, so a
+        //   poller can compare it with the version it last saw instead of comparing values.
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const KeywordHandle _handle - keyword handle
+        // Return:
+        //   uint32_t version, 0 if the handle is invalid.
+
+        if (_handle >= get_storage_ptr(_memory)->nkw)
+            return 0;
+        return std::atomic_ref<uint32_t>(get_keyword_values_ptr(_memory)[_handle].version).load(std::memory_order_acquire);
+    }
+
+    inline int update_creation_time(SharedStorage *_storage)
+    {
+        struct timespec now;
+        int ret = clock_gettime(CLOCK_REALTIME, &now);
+        store_timespec(_storage->creationtime, now);
+        store_timespec(_storage->lastaccesstime, now); // Update last access time
+        return ret;
+    }
+
+    inline int lock(SharedStorage *_storage)
+    {
+        // lock
+        //   lock the stream mutex. if its owner died holding it the mutex is marked consistent and the lock is taken;
+        //   the state it guards is atomic and valid at every point, so there is nothing else to repair.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   0 on success, the error number of pthread_mutex_lock() otherwise.
+
+        int ret = pthread_mutex_lock(&_storage->mutex);
+        if (ret == EOWNERDEAD)
+            ret = pthread_mutex_consistent(&_storage->mutex);
+        return ret;
+    }
+
+    inline int unlock(SharedStorage *_storage)
+    {
+        return pthread_mutex_unlock(&_storage->mutex);
+    }
+
+    inline int cond_wait(SharedStorage *_storage, pthread_cond_t *_cond, const struct timespec *_deadline)
+    {
+        // cond_wait
+        //   wait on a condition variable of the stream with the mutex held, recovering the mutex like lock().
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   pthread_cond_t *_cond - condition variable
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 when woken, ETIMEDOUT on deadline, another error number on failure.
+
+        int ret = _deadline ? pthread_cond_timedwait(_cond, &_storage->mutex, _deadline)
+                            : pthread_cond_wait(_cond, &_storage->mutex);
+        if (ret == EOWNERDEAD)
+            ret = pthread_mutex_consistent(&_storage->mutex);
+        return ret;
+    }
+
+    inline int post_request(SharedStorage *_storage)
+    {
+        // set request flag to true
+        if (_storage->flags & SHMIO_FUTEX)
+        {
+            futex_store_wake(&_storage->has_request, &_storage->request_waiters, 1);
+            return 0;
+        }
+        // ==== begin critical section ================================================================================
+        lock(_storage);
+        _storage->has_request.store(1, std::memory_order_release); // request frame from storage
+        pthread_cond_signal(&_storage->has_request_cond);
+        unlock(_storage);
+        // ==== end critical section ==================================================================================
+        return 0;
+    }
+
+    inline int wait_for_response_until(SharedStorage *_storage, const struct timespec *_deadline, const WaitPolicy &_policy, WaitStats *_stats = nullptr)
+    {
+        // wait for has_response to become true or _deadline (CLOCK_MONOTONIC, nullptr for none) to pass, spinning
+        // first according to _policy. returns -1 with errno ETIMEDOUT on timeout, the response is left pending
+        // set ready flag to false
+        WaitPhase phase = spin_wait(_policy, [&]
+                                    { return _storage->has_response.load(std::memory_order_acquire) != 0; },
+                                    _deadline ? timespec_ns(*_deadline) : UINT64_MAX);
+        if (_storage->flags & SHMIO_FUTEX)
+        {
+            uint32_t expected = 1;
+            while (!_storage->has_response.compare_exchange_weak(expected, 0, std::memory_order_acquire, std::memory_order_relaxed))
+            {
+                if (futex_wait_while(&_storage->has_response, &_storage->response_waiters, 0, _deadline) == -1)
+                {
+                    count_wait(_stats, phase, false);
+                    return -1;
+                }
+                expected = 1;
+            }
+            count_wait(_stats, phase, true);
+            return 0;
+        }
+        int ret = 0;
+        // ==== begin critical section ================================================================================
+        lock(_storage);
+        while (!_storage->has_response.load(std::memory_order_acquire) && ret == 0) // wait for frame ready
+            ret = cond_wait(_storage, &_storage->has_response_cond, _deadline);
+        if (_storage->has_response.load(std::memory_order_relaxed))
+        {
+            _storage->has_response.store(0, std::memory_order_relaxed);
+            ret = 0;
         }
+        unlock(_storage);
+        // ==== end critical section ==================================================================================
+        count_wait(_stats, phase, ret == 0);
+        if (ret != 0)
+        {
+            errno = ret;
+            return -1;
+        }
+        return 0;
+    }
+
+    inline int wait_for_response_until(SharedStorage *_storage, const struct timespec *_deadline)
+    {
+        return wait_for_response_until(_storage, _deadline, get_wait_policy(_storage));
+    }
+
+    inline int wait_for_response_for(SharedStorage *_storage, const uint64_t _timeout_ns)
+    {
+        struct timespec deadline = monotonic_deadline(_timeout_ns);
+        return wait_for_response_until(_storage, &deadline);
+    }
+
+    inline int wait_for_response(SharedStorage *_storage, const WaitPolicy &_policy, WaitStats *_stats = nullptr)
+    {
+        return wait_for_response_until(_storage, nullptr, _policy, _stats);
+    }
+
+    inline int wait_for_response(SharedStorage *_storage)
+    {
+        return wait_for_response_until(_storage, nullptr, get_wait_policy(_storage));
+    }
+
+    inline int wait_for_request_until(SharedStorage *_storage, const struct timespec *_deadline, const WaitPolicy &_policy, WaitStats *_stats = nullptr)
+    {
+        // wait for request flag to become true or _deadline (CLOCK_MONOTONIC, nullptr for none) to pass, spinning
+        // first according to _policy. returns -1 with errno ETIMEDOUT on timeout
+        WaitPhase phase = spin_wait(_policy, [&]
+                                    { return _storage->has_request.load(std::memory_order_acquire) != 0; },
+                                    _deadline ? timespec_ns(*_deadline) : UINT64_MAX);
+        if (_storage->flags & SHMIO_FUTEX)
+        {
+            int ret = futex_wait_while(&_storage->has_request, &_storage->request_waiters, 0, _deadline);
+            count_wait(_stats, phase, ret == 0);
+            return ret;
+        }
+        int ret = 0;
+        // ==== begin critical section ================================================================================
+        lock(_storage);
+        while (!_storage->has_request.load(std::memory_order_acquire) && ret == 0) // wait for request
+            ret = cond_wait(_storage, &_storage->has_request_cond, _deadline);
+        if (_storage->has_request.load(std::memory_order_relaxed))
+            ret = 0;
+        unlock(_storage);
+        // ==== end critical section ==================================================================================
+        count_wait(_stats, phase, ret == 0);
+        if (ret != 0)
+        {
+            errno = ret;
+            return -1;
+        }
+        return 0;
+    }
+
+    inline int wait_for_request_until(SharedStorage *_storage, const struct timespec *_deadline)
+    {
+        return wait_for_request_until(_storage, _deadline, get_wait_policy(_storage));
+    }
+
+    inline int wait_for_request_for(SharedStorage *_storage, const uint64_t _timeout_ns)
+    {
+        struct timespec deadline = monotonic_deadline(_timeout_ns);
+        return wait_for_request_until(_storage, &deadline);
+    }
+
+    inline int wait_for_request(SharedStorage *_storage, const WaitPolicy &_policy, WaitStats *_stats = nullptr)
+    {
+        return wait_for_request_until(_storage, nullptr, _policy, _stats);
+    }
+
+    inline int wait_for_request(SharedStorage *_storage)
+    {
+        return wait_for_request_until(_storage, nullptr, get_wait_policy(_storage));
+    }
+
+    inline bool publish_response(SharedStorage *_storage)
+    {
+        // publish_response
+        //   publish the frame of a response to wait_for_frame() subscribers, unless the responder produced it through
+        //   begin_write()/end_write(), which already published it. every frame is published once.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   true if the frame was published here.
+
+        uint64_t index = _storage->write_index.load(std::memory_order_relaxed);
+        if (_storage->response_index.exchange(index, std::memory_order_relaxed) != index) // end_write() since the last response
+            return false;
+        publish_frame(_storage);
+        return true;
+    }
+
+    inline void signal_response(SharedStorage *_storage)
+    {
+        // set request flag to false
+        // set ready flag to true
+        if (_storage->flags & SHMIO_FUTEX)
+        {
+            _storage->has_request.store(0, std::memory_order_relaxed);
+            futex_store_wake(&_storage->has_response, &_storage->response_waiters, 1);
+            return;
+        }
+        // ==== begin critical section ================================================================================
+        lock(_storage);
+        _storage->has_request.store(0, std::memory_order_relaxed);
+        _storage->has_response.store(1, std::memory_order_release);
+        pthread_cond_signal(&_storage->has_response_cond);
+        unlock(_storage);
+        // ==== end critical section ==================================================================================
+    }
+
+    inline int post_response(SharedStorage *_storage)
+    {
+        // post_response
+        //   signal the pending requester and publish the response frame to wait_for_frame() subscribers, has_response
+        //   only serves one. see publish_response().
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   0.
 
-        size_t data_size = shared_memory_size(_keywords.size(), _npx, _dtype);
-        size_t file_size = static_cast<size_t>(file_stat.st_size);
-        if (file_size != data_size)
-        {
-            close(_memory.fd);
-            _memory.fd = -1;
-            return -1;
-        }
+        signal_response(_storage);
+        publish_response(_storage);
+        return 0;
+    }
 
-        _memory.size = file_size;
-        _memory.base = mmap(nullptr, _memory.size, PROT_READ | PROT_WRITE, MAP_SHARED, _memory.fd, 0);
-        if (_memory.base == MAP_FAILED)
-        {
-            _memory.base = nullptr;
-            close(_memory.fd);
-            _memory.fd = -1;
-            return -1;
-        }
+    inline int post_response(SharedMemory &_memory)
+    {
+        // post_response
+        //   post_response() on the storage, then signal the notification subscribers of the stream if the frame was not
+        //   already published by end_write().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        // Return:
+        //   0.
 
         SharedStorage *storage = get_storage_ptr(_memory);
-        clock_gettime(CLOCK_REALTIME, &storage->lastaccesstime);
+        signal_response(storage);
+        if (publish_response(storage))
+            notify_subscribers(_memory);
+        return 0;
+    }
+
+    inline bool poll_request(SharedStorage *_storage)
+    {
+        // poll_request
+        //   check for a pending request without the mutex. a true result synchronizes with post_request().
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   true if a request is pending.
+
+        return _storage->has_request.load(std::memory_order_acquire) != 0;
+    }
+
+    inline bool poll_response(SharedStorage *_storage)
+    {
+        // poll_response
+        //   check for a pending response without the mutex or consuming it. a true result synchronizes with
+        //   post_response(), so the data published before it is visible.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   true if a response is pending.
 
-        std::span<Keyword> keywords = get_keywords(_memory);
-        for (size_t ikw = 0; ikw < storage->nkw && ikw < _keywords.size(); ++ikw)
+        return _storage->has_response.load(std::memory_order_acquire) != 0;
+    }
+
+    static_assert((SHMIO_REQUEST_QUEUE_SIZE & (SHMIO_REQUEST_QUEUE_SIZE - 1)) == 0 && SHMIO_REQUEST_QUEUE_SIZE >= 8,
+                  "SHMIO_REQUEST_QUEUE_SIZE must be a power of two of at least 8");
+
+    template <typename Ready>
+    inline int futex_wait_ready(std::atomic<uint32_t> *_word, std::atomic<uint32_t> *_waiters, Ready &&_ready, const struct timespec *_deadline)
+    {
+        // futex_wait_ready
+        //   block until _ready() is true. the wakers change the state _ready() checks, then bump _word and wake the
+        //   parked threads if _waiters is not zero. _ready() is not called again once it returned true, so it may
+        //   consume what it found.
+        // Parameters:
+        //   std::atomic<uint32_t> *_word - futex word
+        //   std::atomic<uint32_t> *_waiters - waiter count
+        //   Ready &&_ready - predicate, true once the wait is satisfied
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 once _ready() is true, -1 with errno ETIMEDOUT if the deadline passed first.
+
+        while (!_ready())
         {
-            if (std::strncmp(keywords[ikw].name, _keywords[ikw].name, KEYWORD_MAX_STRING) != 0)
+            long ret = 0;
+            _waiters->fetch_add(1, std::memory_order_seq_cst);
+            uint32_t word = _word->load(std::memory_order_seq_cst);
+            bool ready = _ready();
+            if (!ready)
+                ret = futex_wait(_word, word, _deadline);
+            int err = errno;
+            _waiters->fetch_sub(1, std::memory_order_relaxed);
+            if (ready)
+                return 0;
+            if (ret == -1 && err == ETIMEDOUT)
             {
-                // kato::log::cout << KATO_RED << "setup_open_shared_memory() - keyword " << ikw << "name not matching." << KATO_RESET << std::endl;
-                munmap(_memory.base, _memory.size);
-                _memory.base = nullptr;
-                close(_memory.fd);
-                _memory.fd = -1;
+                if (_ready())
+                    return 0;
+                errno = ETIMEDOUT; // _ready() may have set errno
                 return -1;
             }
+        }
+        return 0;
+    }
+
+    inline void futex_bump_wake(std::atomic<uint32_t> *_word, std::atomic<uint32_t> *_waiters)
+    {
+        _word->fetch_add(1, std::memory_order_seq_cst);
+        if (_waiters->load(std::memory_order_seq_cst) != 0)
+            futex_wake(_word, INT_MAX);
+    }
+
+    inline RequestEntry &get_request_entry(SharedStorage *_storage, const uint64_t _ticket)
+    {
+        return _storage->queue[_ticket & (SHMIO_REQUEST_QUEUE_SIZE - 1)];
+    }
+
+    inline int cancel_ticket(SharedStorage *_storage, const uint64_t _ticket)
+    {
+        // cancel_ticket
+        //   give up a ticket whose response will not be collected. a posted response is dropped and the entry freed;
+        //   a request not taken yet is skipped by the responders, and one already taken is freed by the
+        //   post_ticket_response() of its responder, or by reclaim_dead_tickets() if that responder died.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _ticket - ticket returned by post_ticket_request()
+        // Return:
+        //   0 on success, -1 with errno EINVAL if _ticket is not pending (collected or cancelled already).
+
+        RequestEntry &entry = get_request_entry(_storage, _ticket);
+        uint64_t seq = entry.seq.load(std::memory_order_acquire);
+        while (true)
+        {
+            uint64_t next;
+            if (seq == _ticket + TICKET_REQUESTED)
+                next = _ticket + TICKET_CANCELLED;
+            else if (seq == _ticket + TICKET_TAKEN)
+                next = _ticket + TICKET_ABANDONED;
+            else if (seq == _ticket + TICKET_RESPONDED)
+                next = _ticket + SHMIO_REQUEST_QUEUE_SIZE; // drop the response, free for the ticket one lap later
             else
             {
-                if (std::strncmp(keywords[ikw].comment, _keywords[ikw].comment, KEYWORD_MAX_COMMENT) != 0)
-                {
-                    // kato::log::cout << KATO_RED << "setup_open_shared_memory() - keyword " << ikw << "comment not matching." << KATO_RESET << std::endl;
-                    munmap(_memory.base, _memory.size);
-                    _memory.base = nullptr;
-                    close(_memory.fd);
-                    _memory.fd = -1;
-                    return -1;
-                }
-                else
-                {
-                    if (keywords[ikw].type != _keywords[ikw].type)
-                    {
-                        // kato::log::cout << KATO_RED << "setup_open_shared_memory() - keyword " << ikw << "type not matching." << KATO_RESET << std::endl;
-                        munmap(_memory.base, _memory.size);
-                        _memory.base = nullptr;
-                        close(_memory.fd);
-                        _memory.fd = -1;
-                        return -1;
-                    }
-                    else
-                    {
-                        switch (keywords[ikw].type)
-                        {
-                        case KeywordType::DOUBLE:
-                            keywords[ikw].value.numf = _keywords[ikw].value.numf;
-                            break;
-                        case KeywordType::LONG:
-                            keywords[ikw].value.numl = _keywords[ikw].value.numl;
-                            break;
-                        case KeywordType::STRING:
-                            std::strncpy(keywords[ikw].value.valstr, _keywords[ikw].value.valstr, KEYWORD_STR_VAL_MAX_STRING);
-                            break;
-                        default:
-                            break;
-                        }
-                    }
-                }
+                errno = EINVAL;
+                return -1;
             }
+            if (entry.seq.compare_exchange_weak(seq, next, std::memory_order_acq_rel, std::memory_order_acquire))
+                return 0;
         }
+    }
 
-        _memory.data = get_pixels_ptr(_memory);
-
-        return 0;
+    inline bool process_dead(const pid_t _pid)
+    {
+        return _pid != 0 && kill(_pid, 0) == -1 && errno == ESRCH;
     }
 
-    inline int setup_open_shared_memory(SharedMemory &_memory)
+    inline size_t skip_taken_tickets(SharedStorage *_storage)
     {
-        // setup_open_shared_memory
-        //   setup a shared memory.
+        // skip_taken_tickets
+        //   move queue_head past the tickets a responder no longer has to take: taken, answered or cancelled. the
+        //   entries of tickets cancelled before they were taken are freed here.
         // Parameters:
-        //   SharedMemory &_memory - memory
+        //   SharedStorage *_storage - storage
         // Return:
-        //   0 if shared memory is setup correctly otherwise the shared memory will be closed gracefully.
+        //   size_t number of queue entries freed.
 
-        if (_memory.name.empty())
+        size_t freed = 0;
+        uint64_t ticket = _storage->queue_head.load(std::memory_order_relaxed);
+        while (true)
         {
-            return -1;
+            RequestEntry &entry = get_request_entry(_storage, ticket);
+            uint64_t seq = entry.seq.load(std::memory_order_acquire);
+            if (seq <= ticket + TICKET_REQUESTED) // not requested yet, or waiting for a responder
+                return freed;
+            uint64_t cancelled = ticket + TICKET_CANCELLED;
+            if (entry.seq.compare_exchange_strong(cancelled, ticket + SHMIO_REQUEST_QUEUE_SIZE, std::memory_order_release)) // free for the ticket one lap later
+                ++freed;
+            _storage->queue_head.compare_exchange_strong(ticket, ticket + 1, std::memory_order_relaxed); // fails if another thread moved it on
+            ticket = _storage->queue_head.load(std::memory_order_relaxed);
         }
+    }
 
-        std::string path = shm_path(_memory.name);
-        _memory.fd = shm_open(path.c_str(), O_RDWR, 0); // Open existing shared memory object (read/write)
-        if (_memory.fd == -1)
+    inline size_t reclaim_dead_tickets(SharedStorage *_storage)
+    {
+        // reclaim_dead_tickets
+        //   cancel the pending tickets of requesters whose process no longer exists (kill(pid, 0) fails with ESRCH),
+        //   free the cancelled tickets whose responder died before answering, and skip the cancelled requests no
+        //   responder took, so their entries return to the queue. called by post_ticket_request() when the queue is
+        //   full.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        // Return:
+        //   size_t number of queue entries freed.
+
+        size_t freed = 0;
+        for (uint64_t i = 0; i < SHMIO_REQUEST_QUEUE_SIZE; ++i)
         {
-            return -1;
+            RequestEntry &entry = _storage->queue[i];
+            uint64_t seq = entry.seq.load(std::memory_order_acquire);
+            uint64_t state = (seq - i) & (SHMIO_REQUEST_QUEUE_SIZE - 1);
+            uint64_t ticket = seq - state;
+            if ((state == TICKET_REQUESTED || state == TICKET_RESPONDED || state == TICKET_TAKEN) &&
+                process_dead(entry.pid.load(std::memory_order_relaxed)) && cancel_ticket(_storage, ticket) == 0) // fails if the entry moved on
+            {
+                if (state == TICKET_RESPONDED)
+                    ++freed;
+                state = state == TICKET_TAKEN ? TICKET_ABANDONED : TICKET_CANCELLED;
+            }
+            uint64_t abandoned = ticket + TICKET_ABANDONED;
+            if (state == TICKET_ABANDONED && process_dead(entry.responder.load(std::memory_order_relaxed)) &&
+                entry.seq.compare_exchange_strong(abandoned, ticket + SHMIO_REQUEST_QUEUE_SIZE, std::memory_order_release)) // no response will come
+                ++freed;
         }
+        return freed + skip_taken_tickets(_storage);
+    }
 
-        struct stat file_stat;
-        if (fstat(_memory.fd, &file_stat) == -1) // Get the size of the shared memory object
+    inline int post_ticket_request(SharedStorage *_storage, const uint64_t _argument, uint64_t &_ticket)
+    {
+        // post_ticket_request
+        //   queue a request and get its ticket. any number of requests, from any number of clients, may be in flight;
+        //   each client collects the response to each of its tickets with wait_for_ticket_response().
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _argument - argument passed to the responder
+        //   uint64_t &_ticket - receives the ticket of the request
+        // Return:
+        //   0 if queued, -1 with errno EAGAIN if the queue entry of the next ticket still holds the request or the
+        //   uncollected response of the ticket SHMIO_REQUEST_QUEUE_SIZE earlier, and its requester is alive.
+
+        uint64_t ticket = _storage->queue_tail.load(std::memory_order_relaxed);
+        bool reclaimed = false;
+        while (true)
         {
-            close(_memory.fd);
-            return -1;
+            RequestEntry &entry = get_request_entry(_storage, ticket);
+            uint64_t seq = entry.seq.load(std::memory_order_acquire);
+            if (seq == ticket)
+            {
+                if (_storage->queue_tail.compare_exchange_weak(ticket, ticket + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (seq < ticket) // the entry still holds an uncollected request or response
+            {
+                if (reclaimed || reclaim_dead_tickets(_storage) == 0) // queue full, make room if a requester died
+                {
+                    errno = EAGAIN;
+                    return -1;
+                }
+                reclaimed = true;
+                ticket = _storage->queue_tail.load(std::memory_order_relaxed);
+            }
+            else
+                ticket = _storage->queue_tail.load(std::memory_order_relaxed);
         }
+        RequestEntry &entry = get_request_entry(_storage, ticket);
+        entry.argument.store(_argument, std::memory_order_relaxed);
+        entry.pid.store(getpid(), std::memory_order_relaxed);
+        entry.responder.store(0, std::memory_order_relaxed);
+        entry.seq.store(ticket + TICKET_REQUESTED, std::memory_order_release);
+        futex_bump_wake(&_storage->queue_request_word, &_storage->queue_request_waiters);
+        _ticket = ticket;
+        return 0;
+    }
 
-        size_t file_size = static_cast<size_t>(file_stat.st_size);
-        _memory.size = file_size;
-        _memory.base = mmap(nullptr, _memory.size, PROT_READ | PROT_WRITE, MAP_SHARED, _memory.fd, 0);
-        if (_memory.base == MAP_FAILED)
+    inline int poll_ticket_request(SharedStorage *_storage, uint64_t &_ticket, uint64_t &_argument)
+    {
+        // poll_ticket_request
+        //   take the oldest queued request, without blocking. several responders may take requests concurrently.
+        //   requests cancelled before they were taken are skipped and their entries freed.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   uint64_t &_ticket - receives the ticket to answer with post_ticket_response()
+        //   uint64_t &_argument - receives the argument of the request
+        // Return:
+        //   0 if a request was taken, -1 with errno EAGAIN if none is queued.
+
+        while (true)
         {
-            close(_memory.fd);
-            return -1;
+            skip_taken_tickets(_storage);
+            uint64_t ticket = _storage->queue_head.load(std::memory_order_relaxed);
+            RequestEntry &entry = get_request_entry(_storage, ticket);
+            uint64_t seq = ticket + TICKET_REQUESTED;
+            if (entry.seq.compare_exchange_strong(seq, ticket + TICKET_TAKEN, std::memory_order_acq_rel, std::memory_order_acquire))
+            {
+                entry.responder.store(getpid(), std::memory_order_relaxed);
+                _ticket = ticket;
+                _storage->queue_head.compare_exchange_strong(ticket, ticket + 1, std::memory_order_relaxed); // fails if another thread moved it on
+                _argument = entry.argument.load(std::memory_order_relaxed);
+                return 0;
+            }
+            if (seq <= ticket) // not requested yet
+            {
+                errno = EAGAIN;
+                return -1;
+            }
         }
+    }
 
-        SharedStorage *storage = get_storage_ptr(_memory);
-
-        clock_gettime(CLOCK_REALTIME, &storage->lastaccesstime);
+    inline int wait_for_ticket_request_until(SharedStorage *_storage, uint64_t &_ticket, uint64_t &_argument, const struct timespec *_deadline)
+    {
+        // wait_for_ticket_request_until
+        //   take the oldest queued request, waiting for one until _deadline.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   uint64_t &_ticket - receives the ticket to answer with post_ticket_response()
+        //   uint64_t &_argument - receives the argument of the request
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 if a request was taken, -1 with errno ETIMEDOUT if the deadline passed first.
 
-        _memory.data = get_pixels_ptr(_memory);
+        auto taken = [&]
+        { return poll_ticket_request(_storage, _ticket, _argument) == 0; };
+        if (spin_wait(get_wait_policy(_storage), taken, _deadline ? timespec_ns(*_deadline) : UINT64_MAX) != WaitPhase::BLOCK)
+            return 0;
+        return futex_wait_ready(&_storage->queue_request_word, &_storage->queue_request_waiters, taken, _deadline);
+    }
 
-        return 0;
+    inline int wait_for_ticket_request(SharedStorage *_storage, uint64_t &_ticket, uint64_t &_argument)
+    {
+        return wait_for_ticket_request_until(_storage, _ticket, _argument, nullptr);
     }
 
-    inline int create_open_shared_memory(SharedMemory &_memory, const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords)
+    inline int post_ticket_response(SharedStorage *_storage, const uint64_t _ticket, const uint64_t _result)
     {
-        // create_open_shared_memory
-        //   create a shared memory. if a shared memory by that name exists an attempt will be made to use it.
+        // post_ticket_response
+        //   answer a request taken with poll_ticket_request() or wait_for_ticket_request().
         // Parameters:
-        //   SharedMemory &_memory - memory
-        //   const char *_name - filename
-        //   const size_t _npx - number of pixels
-        //   const DataType _dtype - type of pixels
-        //   const std::vector<Keyword> &_keywords - keywords
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _ticket - ticket of the request
+        //   const uint64_t _result - result passed to the requester, e.g. the frame holding the data
         // Return:
-        //   0 if stream is created correctly. leaves the stream open.
+        //   0 on success, also if the requester cancelled the ticket (the response is dropped), -1 with errno EINVAL if
+        //   _ticket is not a taken request.
 
-        if (_memory.name.empty())
+        RequestEntry &entry = get_request_entry(_storage, _ticket);
+        uint64_t seq = entry.seq.load(std::memory_order_relaxed);
+        if (seq != _ticket + TICKET_TAKEN && seq != _ticket + TICKET_ABANDONED)
         {
+            errno = EINVAL;
             return -1;
         }
-
-        std::string path = shm_path(_memory.name);
-        _memory.fd = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
-        if (_memory.fd < 0)
+        entry.result.store(_result, std::memory_order_relaxed);
+        if (seq == _ticket + TICKET_ABANDONED || !entry.seq.compare_exchange_strong(seq, _ticket + TICKET_RESPONDED, std::memory_order_release, std::memory_order_relaxed))
         {
-            return -1;
+            entry.seq.store(_ticket + SHMIO_REQUEST_QUEUE_SIZE, std::memory_order_release); // cancelled: free for the ticket one lap later
+            return 0;
         }
+        futex_bump_wake(&_storage->queue_response_word, &_storage->queue_response_waiters);
+        return 0;
+    }
 
-        _memory.size = shared_memory_size(_keywords.size(), _npx, _dtype);
-        if (ftruncate(_memory.fd, _memory.size) == -1)
-        {
-            close(_memory.fd);
-            _memory.fd = -1;
-            return -1;
-        }
+    inline int poll_ticket_response(SharedStorage *_storage, const uint64_t _ticket, uint64_t &_result)
+    {
+        // poll_ticket_response
+        //   collect the response to _ticket if it has been posted, freeing its queue entry.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _ticket - ticket returned by post_ticket_request()
+        //   uint64_t &_result - receives the result of the response
+        // Return:
+        //   0 if the response was collected, -1 with errno EAGAIN if it is not posted yet.
 
-        _memory.base = mmap(nullptr, _memory.size, PROT_READ | PROT_WRITE, MAP_SHARED, _memory.fd, 0);
-        if (_memory.base == MAP_FAILED)
+        RequestEntry &entry = get_request_entry(_storage, _ticket);
+        if (entry.seq.load(std::memory_order_acquire) != _ticket + TICKET_RESPONDED)
         {
-            _memory.base = nullptr;
-            close(_memory.fd);
-            _memory.fd = -1;
+            errno = EAGAIN;
             return -1;
         }
+        _result = entry.result.load(std::memory_order_relaxed);
+        entry.seq.store(_ticket + SHMIO_REQUEST_QUEUE_SIZE, std::memory_order_release); // free for the ticket one lap later
+        return 0;
+    }
 
-        SharedStorage *storage = get_storage_ptr(_memory);
-
-        // Initialize mutex (only once, by creator)
-        pthread_mutexattr_t mattr;
-        pthread_mutexattr_init(&mattr);
-        pthread_mutexattr_setpshared(&mattr, PTHREAD_PROCESS_SHARED);
-        pthread_mutex_init(&storage->mutex, &mattr);
-        pthread_mutexattr_destroy(&mattr);
-
-        pthread_condattr_t cattr;
-        pthread_condattr_init(&cattr);
-        pthread_condattr_setpshared(&cattr, PTHREAD_PROCESS_SHARED);
-        pthread_cond_init(&storage->has_request_cond, &cattr);
-        pthread_cond_init(&storage->has_response_cond, &cattr);
-        pthread_condattr_destroy(&cattr);
+    inline int wait_for_ticket_response_until(SharedStorage *_storage, const uint64_t _ticket, uint64_t &_result, const struct timespec *_deadline)
+    {
+        // wait_for_ticket_response_until
+        //   wait for and collect the response to _ticket. responses are broadcast, each requester checks its own ticket.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint64_t _ticket - ticket returned by post_ticket_request()
+        //   uint64_t &_result - receives the result of the response
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 if the response was collected, -1 with errno ETIMEDOUT if the deadline passed first. the ticket stays
+        //   valid after a timeout and must still be collected, or given up with cancel_ticket().
+
+        auto collected = [&]
+        { return poll_ticket_response(_storage, _ticket, _result) == 0; };
+        if (spin_wait(get_wait_policy(_storage), collected, _deadline ? timespec_ns(*_deadline) : UINT64_MAX) != WaitPhase::BLOCK)
+            return 0;
+        return futex_wait_ready(&_storage->queue_response_word, &_storage->queue_response_waiters, collected, _deadline);
+    }
 
-        clock_gettime(CLOCK_REALTIME, &storage->creationtime);
-        storage->lastaccesstime = storage->creationtime;
-        storage->nkw = _keywords.size();
-        storage->npx = _npx;
-        storage->dtype = _dtype;
-        storage->has_request = false;
-        storage->has_response = false;
+    inline int wait_for_ticket_response_for(SharedStorage *_storage, const uint64_t _ticket, uint64_t &_result, const uint64_t _timeout_ns)
+    {
+        struct timespec deadline = monotonic_deadline(_timeout_ns);
+        return wait_for_ticket_response_until(_storage, _ticket, _result, &deadline);
+    }
 
-        char *base = reinterpret_cast<char *>(get_keywords_ptr(_memory));
-        std::memcpy(base, _keywords.data(), _keywords.size() * sizeof(Keyword));
+    inline int wait_for_ticket_response(SharedStorage *_storage, const uint64_t _ticket, uint64_t &_result)
+    {
+        return wait_for_ticket_response_until(_storage, _ticket, _result, nullptr);
+    }
 
-        _memory.data = get_pixels_ptr(_memory);
+    inline int post_coalesced_request(SharedStorage *_storage, uint32_t &_generation)
+    {
+        // post_coalesced_request
+        //   ask for the next frame. every request posted before the responder calls begin_coalesced_frame() is
+        //   satisfied by that one frame.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   uint32_t &_generation - receives the generation of the frame that satisfies the request
+        // Return:
+        //   0.
 
+        uint64_t state = _storage->coalesce_state.fetch_add(1, std::memory_order_acq_rel);
+        _generation = static_cast<uint32_t>(state >> 32) + 1;
+        futex_bump_wake(&_storage->coalesce_request_word, &_storage->coalesce_request_waiters);
         return 0;
-    };
+    }
 
-    inline int create_open_shared_memory(SharedMemory &_memory, const char *_name, const size_t _npx, const DataType _dtype, const std::vector<Keyword> &_keywords)
+    inline uint32_t poll_coalesced_request(SharedStorage *_storage)
     {
-        // create_open_shared_memory
-        //   Create an opened shared memory. if a shared memory by that name exists an attempt will be made to use it.
+        // poll_coalesced_request
+        //   get the number of requests waiting for the next coalesced frame.
         // Parameters:
-        //   SharedMemory &_memory - memory
-        //   const char *_name - filename
-        //   const size_t _npx - number of pixels
-        //   const DataType _dtype - type of pixels
-        //   const std::vector<Keyword> &_keywords - keywords
+        //   SharedStorage *_storage - storage
         // Return:
-        //   0 if stream is created correctly. leaves the stream open.
+        //   uint32_t number of pending requests.
 
-        _memory.name = _name;
-        int ret = create_open_shared_memory(_memory, _npx, _dtype, _keywords);
-        if (ret == -1 && errno == EEXIST)
-            return setup_open_shared_memory(_memory, _npx, _dtype, _keywords);
-        return ret;
+        return static_cast<uint32_t>(_storage->coalesce_state.load(std::memory_order_acquire));
     }
 
-    inline int open_shared_memory(SharedMemory &_memory, const char *_name)
+    inline int wait_for_coalesced_request_until(SharedStorage *_storage, const struct timespec *_deadline)
     {
-        // open_shared_memory
-        //   open a shared memory by name
+        // wait_for_coalesced_request_until
+        //   wait until at least one coalesced request is pending, or _deadline passes.
         // Parameters:
-        //   SharedMemory &_memory - memory
-        //   const std::string _name - filename
+        //   SharedStorage *_storage - storage
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
         // Return:
-        //   0 if stream is created correctly. leaves the stream open.
+        //   0 once a request is pending, -1 with errno ETIMEDOUT if the deadline passed first.
 
-        _memory.name = _name;
-        return setup_open_shared_memory(_memory);
+        auto pending = [&]
+        { return poll_coalesced_request(_storage) != 0; };
+        if (spin_wait(get_wait_policy(_storage), pending, _deadline ? timespec_ns(*_deadline) : UINT64_MAX) != WaitPhase::BLOCK)
+            return 0;
+        return futex_wait_ready(&_storage->coalesce_request_word, &_storage->coalesce_request_waiters, pending, _deadline);
     }
 
-    inline Keyword *find_keyword(SharedMemory &_memory, const char *name) // Find keyword by name
+    inline int wait_for_coalesced_request(SharedStorage *_storage)
     {
-        for (Keyword &keyword : get_keywords(_memory))
-        {
-            if (std::strncmp(keyword.name, name, KEYWORD_MAX_STRING) == 0)
-            {
-                return &keyword;
-            }
-        }
-        return nullptr;
+        return wait_for_coalesced_request_until(_storage, nullptr);
     }
 
-    inline int update_creation_time(SharedStorage *_storage)
+    inline uint32_t begin_coalesced_frame(SharedStorage *_storage, uint32_t *_count = nullptr)
     {
-        int ret = clock_gettime(CLOCK_REALTIME, &_storage->creationtime);
-        _storage->lastaccesstime = _storage->creationtime; // Update last access time
-        return ret;
+        // begin_coalesced_frame
+        //   start the frame that satisfies every request pending so far. requests posted from now on wait for the next
+        //   frame. single responder only.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   uint32_t *_count - if not null receives the number of requests the frame satisfies
+        // Return:
+        //   uint32_t generation of the frame, to pass to end_coalesced_frame().
+
+        uint64_t state = _storage->coalesce_state.load(std::memory_order_relaxed);
+        uint64_t next;
+        do
+            next = ((state >> 32) + 1) << 32; // next generation, no pending request
+        while (!_storage->coalesce_state.compare_exchange_weak(state, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+        if (_count != nullptr)
+            *_count = static_cast<uint32_t>(state);
+        return static_cast<uint32_t>(next >> 32);
     }
 
-    inline int update_last_access_time(SharedStorage *_storage)
+    inline int end_coalesced_frame(SharedStorage *_storage, const uint32_t _generation)
     {
-        return clock_gettime(CLOCK_REALTIME, &_storage->lastaccesstime);
-    }
+        // end_coalesced_frame
+        //   mark the frame started by begin_coalesced_frame() as produced and wake all of its requesters with one
+        //   broadcast. also publishes the frame to wait_for_frame() subscribers unless end_write() already did.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint32_t _generation - generation returned by begin_coalesced_frame()
+        // Return:
+        //   0.
 
-    inline int post_request(SharedStorage *_storage)
-    {
-        // set request flag to true
-        // ==== begin critical section ================================================================================
-        pthread_mutex_lock(&_storage->mutex);
-        _storage->has_request = true; // request frame from storage
-        pthread_cond_signal(&_storage->has_request_cond);
-        pthread_mutex_unlock(&_storage->mutex);
-        // ==== end critical section ==================================================================================
+        futex_store_wake(&_storage->coalesce_served, &_storage->coalesce_served_waiters, _generation);
+        publish_response(_storage);
         return 0;
     }
 
-    inline int wait_for_response(SharedStorage *_storage)
+    inline int end_coalesced_frame(SharedMemory &_memory, const uint32_t _generation)
     {
-        // wait for has_response to become true
-        // set ready flag to false
-        // ==== begin critical section ================================================================================
-        pthread_mutex_lock(&_storage->mutex);
-        while (!_storage->has_response) // wait for frame ready
-            pthread_cond_wait(&_storage->has_response_cond, &_storage->mutex);
-        _storage->has_response = false;
-        pthread_mutex_unlock(&_storage->mutex);
-        // ==== end critical section ==================================================================================
+        // end_coalesced_frame
+        //   end_coalesced_frame() on the storage, then signal the notification subscribers of the stream if the frame
+        //   was not already published by end_write().
+        // Parameters:
+        //   SharedMemory &_memory - shared memory
+        //   const uint32_t _generation - generation returned by begin_coalesced_frame()
+        // Return:
+        //   0.
+
+        SharedStorage *storage = get_storage_ptr(_memory);
+        futex_store_wake(&storage->coalesce_served, &storage->coalesce_served_waiters, _generation);
+        if (publish_response(storage))
+            notify_subscribers(_memory);
         return 0;
     }
 
-    inline int wait_for_request(SharedStorage *_storage)
+    inline bool poll_coalesced_response(SharedStorage *_storage, const uint32_t _generation)
     {
-        // wait for request flag to become true
-        // ==== begin critical section ================================================================================
-        pthread_mutex_lock(&_storage->mutex);
-        while (!_storage->has_request) // wait for request
-            pthread_cond_wait(&_storage->has_request_cond, &_storage->mutex);
-        pthread_mutex_unlock(&_storage->mutex);
-        // ==== end critical section ==================================================================================
-        return 0;
+        // poll_coalesced_response
+        //   check whether the frame of a coalesced request has been produced.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint32_t _generation - generation returned by post_coalesced_request()
+        // Return:
+        //   true if the frame is produced.
+
+        uint32_t served = _storage->coalesce_served.load(std::memory_order_acquire);
+        return static_cast<int32_t>(served - _generation) >= 0; // generations wrap around
     }
 
-    inline int post_response(SharedStorage *_storage)
+    inline int wait_for_coalesced_response_until(SharedStorage *_storage, const uint32_t _generation, const struct timespec *_deadline)
     {
-        // set request flag to false
-        // set ready flag to true
-        // ==== begin critical section ================================================================================
-        pthread_mutex_lock(&_storage->mutex);
-        _storage->has_response = true;
-        _storage->has_request = false;
-        pthread_cond_signal(&_storage->has_response_cond);
-        pthread_mutex_unlock(&_storage->mutex);
-        // ==== end critical section ==================================================================================
-        return 0;
+        // wait_for_coalesced_response_until
+        //   wait until the frame of a coalesced request has been produced, or _deadline passes.
+        // Parameters:
+        //   SharedStorage *_storage - storage
+        //   const uint32_t _generation - generation returned by post_coalesced_request()
+        //   const struct timespec *_deadline - absolute CLOCK_MONOTONIC deadline, nullptr to wait without one
+        // Return:
+        //   0 once the frame is produced, -1 with errno ETIMEDOUT if the deadline passed first.
+
+        auto served = [&]
+        { return poll_coalesced_response(_storage, _generation); };
+        if (spin_wait(get_wait_policy(_storage), served, _deadline ? timespec_ns(*_deadline) : UINT64_MAX) != WaitPhase::BLOCK)
+            return 0;
+        return futex_wait_ready(&_storage->coalesce_served, &_storage->coalesce_served_waiters, served, _deadline);
     }
 
-    inline int lock(SharedStorage *_storage)
+    inline int wait_for_coalesced_response_for(SharedStorage *_storage, const uint32_t _generation, const uint64_t _timeout_ns)
     {
-        return pthread_mutex_lock(&_storage->mutex);
+        struct timespec deadline = monotonic_deadline(_timeout_ns);
+        return wait_for_coalesced_response_until(_storage, _generation, &deadline);
     }
 
-    inline int unlock(SharedStorage *_storage)
+    inline int wait_for_coalesced_response(SharedStorage *_storage, const uint32_t _generation)
     {
-        return pthread_mutex_unlock(&_storage->mutex);
+        return wait_for_coalesced_response_until(_storage, _generation, nullptr);
     }
 
 }
@@ -0,0 +1,66 @@
+// Coalesced requests and the publication of their frames.
+//
+//   - every request posted before begin_coalesced_frame() is satisfied by that one frame, later requests wait for the
+//     next one.
+//   - end_coalesced_frame() on the SharedMemory publishes the frame once and signals the notification fds of the
+//     subscribers, unless the frame was already published and signalled by end_write().
+
+#include "shared_memory.hpp"
+
+#include <cstdio>
+
+using namespace shmio;
+
+#define CHECK(condition)                                                                 \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(condition))                                                                \
+        {                                                                                \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::fflush(stdout);                                                         \
+            std::_Exit(1);                                                               \
+        }                                                                                \
+    } while (0)
+
+int main()
+{
+    shm_unlink("/coalesce_test.shm");
+    SharedMemory producer, consumer;
+    CHECK(create_open_shared_memory(producer, "coalesce_test", 16, DataType::UINT8, {}, 1, SHMIO_FUTEX) == 0);
+    CHECK(listen_notify(producer) == 0);
+    CHECK(open_shared_memory(consumer, "coalesce_test") == 0);
+    CHECK(open_notify_fd(consumer) != -1);
+    SharedStorage *storage = get_storage_ptr(producer);
+
+    // three requests share one frame, published and signalled once
+    uint32_t generations[3], count;
+    for (uint32_t &generation : generations)
+        CHECK(post_coalesced_request(get_storage_ptr(consumer), generation) == 0);
+    CHECK(generations[0] == generations[1] && generations[1] == generations[2]);
+    uint32_t generation = begin_coalesced_frame(storage, &count);
+    CHECK(generation == generations[0] && count == 3);
+    uint32_t late;
+    CHECK(post_coalesced_request(get_storage_ptr(consumer), late) == 0 && late == generation + 1);
+    CHECK(end_coalesced_frame(producer, generation) == 0);
+    for (uint32_t served : generations)
+        CHECK(wait_for_coalesced_response_for(get_storage_ptr(consumer), served, 1000000) == 0);
+    CHECK(!poll_coalesced_response(get_storage_ptr(consumer), late));
+    CHECK(get_frame_count(storage) == 1);
+    CHECK(read_notify_fd(consumer) == 1);
+
+    // a frame written through begin_write()/end_write() is not published or signalled again
+    generation = begin_coalesced_frame(storage, &count);
+    CHECK(generation == late && count == 1);
+    begin_write(producer);
+    end_write(producer);
+    CHECK(end_coalesced_frame(producer, generation) == 0);
+    CHECK(wait_for_coalesced_response_for(get_storage_ptr(consumer), late, 1000000) == 0);
+    CHECK(get_frame_count(storage) == 2);
+    CHECK(read_notify_fd(consumer) == 1);
+
+    close_shared_memory(consumer);
+    close_shared_memory(producer);
+    shm_unlink("/coalesce_test.shm");
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,75 @@
+// Cleanup of a create that fails after the segment was published.
+//
+// A child process without CAP_IPC_LOCK lowers RLIMIT_MEMLOCK below the segment size and creates it with SHMIO_MLOCK.
+// The mlock fails after the header is initialized, so the create must fail, leave the SharedMemory empty and remove the
+// segment, a later open must not find it.
+//
+// Skipped (exit 77) if the limit cannot make mlock fail, e.g. when the capability cannot be dropped.
+
+#include "shared_memory.hpp"
+
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include <cstdio>
+
+using namespace shmio;
+
+#define CHECK(condition)                                                                 \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(condition))                                                                \
+        {                                                                                \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::fflush(stdout);                                                         \
+            std::_Exit(1);                                                               \
+        }                                                                                \
+    } while (0)
+
+static constexpr size_t NPX = 1 << 22;         // well above the limit below
+static constexpr rlim_t MEMLOCK_LIMIT = 65536; // bytes
+
+static int create_locked()
+{
+    if (getuid() == 0 && setuid(65534) == -1) // an unprivileged uid has no CAP_IPC_LOCK
+        return 77;
+    struct rlimit limit = {MEMLOCK_LIMIT, MEMLOCK_LIMIT};
+    if (setrlimit(RLIMIT_MEMLOCK, &limit) == -1)
+        return 77;
+
+    SharedMemory memory;
+    if (create_open_shared_memory(memory, "create_failure_test", NPX, DataType::UINT8, {}, 1, SHMIO_MLOCK) == 0)
+    {
+        close_shared_memory(memory);
+        shm_unlink("/create_failure_test.shm");
+        return 77;
+    }
+    CHECK(errno == ENOMEM || errno == EPERM || errno == EAGAIN);
+    CHECK(memory.base == nullptr && memory.data == nullptr && memory.fd == -1);
+    CHECK(memory.size == 0 && memory.flags == 0 && memory.prefaulted == 0);
+    CHECK(!shm_backing_exists(memory.name));
+
+    SharedMemory other;
+    CHECK(open_shared_memory(other, "create_failure_test") == -1);
+    return 0;
+}
+
+int main()
+{
+    shm_unlink("/create_failure_test.shm");
+    pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0)
+        std::_Exit(create_locked());
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status));
+    shm_unlink("/create_failure_test.shm");
+    if (WEXITSTATUS(status) == 77)
+    {
+        std::printf("mlock could not be made to fail, skipped\n");
+        return 77;
+    }
+    CHECK(WEXITSTATUS(status) == 0);
+    std::printf("ok\n");
+    return 0;
+}
@@ -0,0 +1,125 @@
+// Mixed-priority lock latency with and without SHMIO_PRIO_INHERIT.
+//
+// All threads share one CPU. A SCHED_FIFO low-priority thread holds the stream mutex and still needs CPU time to
+// release it, a high-priority thread blocks on the mutex and a medium-priority thread spins. Without priority
+// inheritance the medium thread starves the holder and the high-priority thread waits for the whole spin; with it the
+// holder runs at the priority of the waiter and releases the mutex after its own work.
+//
+// Needs CAP_SYS_NICE for SCHED_FIFO, skipped (exit 77) otherwise.
+
+#include "shared_memory.hpp"
+
+#include <sched.h>
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+using namespace shmio;
+
+static constexpr uint64_t HOLD_CPU_NS = 20000000;  // CPU time the holder needs before it unlocks
+static constexpr uint64_t SPIN_NS = 500000000;     // longest spin of the medium-priority thread
+static constexpr uint64_t PI_LIMIT_NS = 200000000; // lock latency above this means the inversion was not bounded
+
+static bool set_fifo(const int _priority)
+{
+    sched_param param{};
+    param.sched_priority = _priority;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+}
+
+static uint64_t thread_cpu_ns()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return timespec_ns(now);
+}
+
+static int lock_latency(const uint32_t _flags, uint64_t &_latency_ns)
+{
+    shm_unlink("/prio_inherit_test.shm");
+    SharedMemory memory;
+    if (create_open_shared_memory(memory, "prio_inherit_test", 16, DataType::UINT8, {}, 1, _flags) == -1)
+    {
+        std::perror("create_open_shared_memory");
+        return -1;
+    }
+    SharedStorage *storage = get_storage_ptr(memory);
+
+    std::atomic<bool> locked{false}, acquired{false};
+    std::thread low([&]
+                    {
+        set_fifo(10);
+        lock(storage);
+        locked = true;
+        usleep(10000); // let the other threads start and block
+        uint64_t start = thread_cpu_ns();
+        while (thread_cpu_ns() - start < HOLD_CPU_NS)
+            cpu_relax();
+        unlock(storage); });
+    while (!locked)
+        usleep(1000);
+
+    std::thread high([&]
+                     {
+        set_fifo(30);
+        uint64_t start = monotonic_ns();
+        lock(storage);
+        _latency_ns = monotonic_ns() - start;
+        acquired = true;
+        unlock(storage); });
+
+    usleep(2000); // the high-priority thread blocks on the mutex before the spin starts
+    std::thread medium([&]
+                       {
+        set_fifo(20);
+        uint64_t start = monotonic_ns();
+        while (!acquired && monotonic_ns() - start < SPIN_NS)
+            cpu_relax(); });
+
+    high.join();
+    medium.join();
+    low.join();
+    close_shared_memory(memory);
+    shm_unlink("/prio_inherit_test.shm");
+    return 0;
+}
+
+int main()
+{
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    CPU_SET(0, &cpus);
+    if (sched_setaffinity(0, sizeof(cpus), &cpus) == -1) // threads inherit it
+    {
+        std::perror("sched_setaffinity");
+        return 1;
+    }
+    if (!set_fifo(1))
+    {
+        std::printf("SCHED_FIFO not permitted, skipped\n");
+        return 77;
+    }
+    sched_param param{};
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+
+    uint64_t plain_ns = 0, inherit_ns = 0;
+    if (lock_latency(0, plain_ns) == -1)
+        return 1;
+    if (lock_latency(SHMIO_PRIO_INHERIT, inherit_ns) == -1)
+    {
+        if (errno == ENOTSUP)
+        {
+            std::printf("no PI futex support, skipped\n");
+            return 77;
+        }
+        return 1;
+    }
+    std::printf("high-priority lock latency: %.1f ms plain, %.1f ms with SHMIO_PRIO_INHERIT\n", plain_ns / 1e6, inherit_ns / 1e6);
+    if (inherit_ns > PI_LIMIT_NS)
+    {
+        std::printf("FAIL: priority inversion not bounded\n");
+        return 1;
+    }
+    return 0;
+}
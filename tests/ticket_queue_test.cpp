@@ -0,0 +1,91 @@
+// Ticketed request queue recovery from dead peers.
+//
+//   - a responder process takes a ticket and dies before answering; its requester times out and cancels the ticket,
+//     and the queue must keep accepting requests once it wraps around.
+//   - a requester process fills the queue and dies with requests pending and responses uncollected; its tickets must be
+//     reclaimed when the queue is full.
+
+#include "shared_memory.hpp"
+
+#include <sys/wait.h>
+
+#include <cstdio>
+
+using namespace shmio;
+
+#define CHECK(condition)                                                                 \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(condition))                                                                \
+        {                                                                                \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::fflush(stdout);                                                         \
+            std::_Exit(1);                                                               \
+        }                                                                                \
+    } while (0)
+
+template <typename Child>
+static void run_child(Child _child)
+{
+    pid_t pid = fork();
+    CHECK(pid != -1);
+    if (pid == 0)
+        std::_Exit(_child() ? 0 : 1);
+    int status;
+    CHECK(waitpid(pid, &status, 0) == pid && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+}
+
+static void cycle_queue(SharedStorage *_storage, const int _laps)
+{
+    for (int i = 0; i < _laps * SHMIO_REQUEST_QUEUE_SIZE; ++i)
+    {
+        uint64_t ticket, taken, argument, result;
+        CHECK(post_ticket_request(_storage, i, ticket) == 0);
+        CHECK(poll_ticket_request(_storage, taken, argument) == 0 && taken == ticket && argument == static_cast<uint64_t>(i));
+        CHECK(post_ticket_response(_storage, taken, argument + 1) == 0);
+        CHECK(poll_ticket_response(_storage, ticket, result) == 0 && result == argument + 1);
+    }
+}
+
+int main()
+{
+    shm_unlink("/ticket_queue_test.shm");
+    SharedMemory memory;
+    CHECK(create_open_shared_memory(memory, "ticket_queue_test", 16, DataType::UINT8, {}, 1, SHMIO_FUTEX) == 0);
+    SharedStorage *storage = get_storage_ptr(memory);
+
+    // a responder dies holding a ticket
+    uint64_t ticket, result;
+    CHECK(post_ticket_request(storage, 7, ticket) == 0);
+    run_child([&]
+              {
+        uint64_t taken, argument;
+        return poll_ticket_request(storage, taken, argument) == 0 && taken == ticket && argument == 7; });
+    CHECK(wait_for_ticket_response_for(storage, ticket, result, 1000000) == -1 && errno == ETIMEDOUT);
+    CHECK(cancel_ticket(storage, ticket) == 0);
+    CHECK(cancel_ticket(storage, ticket) == -1 && errno == EINVAL);
+    cycle_queue(storage, 3);
+
+    // a requester dies with a full queue, half of it answered
+    run_child([&]
+              {
+        uint64_t posted, taken, argument;
+        for (int i = 0; i < SHMIO_REQUEST_QUEUE_SIZE; ++i)
+            if (post_ticket_request(storage, i, posted) == -1)
+                return false;
+        for (int i = 0; i < SHMIO_REQUEST_QUEUE_SIZE / 2; ++i)
+            if (poll_ticket_request(storage, taken, argument) == -1 || post_ticket_response(storage, taken, argument) == -1)
+                return false;
+        return true; });
+    cycle_queue(storage, 3);
+
+    // a full queue of live requesters still refuses new tickets
+    for (int i = 0; i < SHMIO_REQUEST_QUEUE_SIZE; ++i)
+        CHECK(post_ticket_request(storage, i, ticket) == 0);
+    CHECK(post_ticket_request(storage, 0, ticket) == -1 && errno == EAGAIN);
+
+    close_shared_memory(memory);
+    shm_unlink("/ticket_queue_test.shm");
+    std::printf("ok\n");
+    return 0;
+}
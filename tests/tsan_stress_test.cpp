@@ -0,0 +1,311 @@
+// Stress test of the lock-free protocol of the shared state, built with -fsanitize=thread.
+//
+// ThreadSanitizer tracks memory by address, so the producer and consumer threads of each case share one mapping of the
+// segment: with a mapping each, neither the shared data nor the atomics that order it would match. Per backend
+// (condition variables and SHMIO_FUTEX):
+//   - a responder fills the pixels and posts a response for every request, the requester polls has_response and checks
+//     the pixels it was answered with,
+//   - a subscriber follows every publish with wait_for_frame() and get_frame_info(),
+//   - a keyword writer publishes pairs of keywords with write_keywords() while the requester reads them as a batch,
+//   - another thread keeps changing the stream wait policy under the waiters.
+// With notification fds, end_write() and post_response() signal subscribers from two threads while a third
+// subscribes and unsubscribes, so the producer accepts and drops subscribers under both publishers.
+// A SHMIO_BACKPRESSURE ring is filled by a writer while two registered readers consume every frame, one copying with
+// read_next_frame() and one in place with acquire_next_frame() / release_frames(). TSan does not model the fences of
+// the pixel seqlock, so the ring is not driven into overwriting its readers.
+// Two responders serve three requesters through the ticket queue, and one responder serves three requesters with
+// coalesced frames.
+// ThreadSanitizer reports any access the memory model of SharedStorage leaves unordered.
+
+#include "shared_memory.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <thread>
+
+using namespace shmio;
+
+static constexpr int N = 3000;
+
+#define CHECK(condition)                                                                 \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(condition))                                                                \
+        {                                                                                \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::fflush(stdout);                                                         \
+            std::_Exit(1);                                                               \
+        }                                                                                \
+    } while (0)
+
+static void stress(const uint32_t _flags)
+{
+    shm_unlink("/tsan_stress_test.shm");
+    std::vector<Keyword> keywords{Keyword("A", KeywordType::LONG, (int64_t)0, ""), Keyword("B", KeywordType::LONG, (int64_t)0, "")};
+    SharedMemory producer;
+    CHECK(create_open_shared_memory(producer, "tsan_stress_test", 2, DataType::UINT64, keywords, 1, _flags) == 0);
+    SharedMemory &consumer = producer;
+    const KeywordHandle handles[2] = {0, 1};
+    std::atomic<bool> done{false};
+
+    std::thread responder([&]
+                          {
+        SharedStorage *storage = get_storage_ptr(producer);
+        for (int i = 0; i < N; ++i)
+        {
+            wait_for_request(storage);
+            uint64_t *pixels = reinterpret_cast<uint64_t *>(producer.data);
+            pixels[0] = i;
+            pixels[1] = ~static_cast<uint64_t>(i);
+            update_last_access_time(storage);
+            post_response(producer);
+        } });
+
+    std::thread subscriber([&]
+                           {
+        SharedStorage *storage = get_storage_ptr(consumer);
+        uint64_t last = 0;
+        while (last < N)
+        {
+            last = wait_for_frame(storage, last);
+            FrameInfo info = get_frame_info(storage);
+            CHECK(info.frame >= last && info.frame <= get_frame_count(storage));
+        } });
+
+    std::thread keyword_writer([&]
+                               {
+        for (int i = 0; i < N; ++i)
+        {
+            KeywordData values[2];
+            values[0].numl = i;
+            values[1].numl = -i;
+            write_keywords(producer, handles, values);
+        } });
+
+    std::thread policy_writer([&]
+                              {
+        for (uint32_t i = 0; !done; ++i)
+        {
+            set_wait_policy(get_storage_ptr(producer), WaitPolicy{i % 2 ? WaitMode::SPIN : WaitMode::BLOCK, i % 64, 0});
+            usleep(100);
+        } });
+
+    SharedStorage *storage = get_storage_ptr(consumer);
+    for (int i = 0; i < N; ++i)
+    {
+        post_request(storage);
+        while (!poll_response(storage))
+            cpu_relax();
+        wait_for_response(storage); // consumes the response
+        const uint64_t *pixels = reinterpret_cast<const uint64_t *>(consumer.data);
+        CHECK(pixels[0] == static_cast<uint64_t>(i) && pixels[1] == ~static_cast<uint64_t>(i));
+        KeywordData values[2];
+        read_keywords(consumer, handles, values);
+        CHECK(values[0].numl == -values[1].numl);
+        load_timespec(storage->lastaccesstime);
+    }
+
+    responder.join();
+    subscriber.join();
+    keyword_writer.join();
+    done = true;
+    policy_writer.join();
+    CHECK(get_frame_count(storage) == N);
+    close_shared_memory(producer);
+    shm_unlink("/tsan_stress_test.shm");
+}
+
+static void stress_notify()
+{
+    shm_unlink("/tsan_stress_test.shm");
+    SharedMemory producer;
+    CHECK(create_open_shared_memory(producer, "tsan_stress_test", 2, DataType::UINT64, {}, 4, SHMIO_FUTEX) == 0);
+    CHECK(listen_notify(producer) == 0);
+    std::atomic<bool> done{false};
+
+    std::thread writer([&]
+                       {
+        for (int i = 0; i < N; ++i)
+        {
+            begin_write(producer);
+            end_write(producer);
+        } });
+
+    std::thread responder([&]
+                          {
+        for (int i = 0; i < N; ++i)
+            post_response(producer); });
+
+    std::thread subscriber([&]
+                           {
+        while (!done)
+        {
+            SharedMemory consumer;
+            CHECK(open_shared_memory(consumer, "tsan_stress_test") == 0);
+            CHECK(open_notify_fd(consumer) != -1);
+            usleep(200);
+            read_notify_fd(consumer);
+            close_shared_memory(consumer);
+        } });
+
+    writer.join();
+    responder.join();
+    done = true;
+    subscriber.join();
+    close_shared_memory(producer);
+    shm_unlink("/tsan_stress_test.shm");
+}
+
+static void stress_ring()
+{
+    shm_unlink("/tsan_stress_test.shm");
+    SharedMemory producer;
+    CHECK(create_open_shared_memory(producer, "tsan_stress_test", 2, DataType::UINT64, {}, 4, SHMIO_FUTEX | SHMIO_BACKPRESSURE) == 0);
+    SharedMemory &consumer = producer;
+    ReaderCursor copier, borrower;
+    CHECK(register_reader(consumer, copier) == 0 && register_reader(consumer, borrower) == 0);
+
+    std::thread writer([&]
+                       {
+        for (int i = 0; i < N; ++i)
+        {
+            uint64_t *pixels = reinterpret_cast<uint64_t *>(begin_write(producer));
+            pixels[0] = i;
+            pixels[1] = ~static_cast<uint64_t>(i);
+            end_write(producer);
+        } });
+
+    std::thread copy_reader([&]
+                            {
+        SharedStorage *storage = get_storage_ptr(consumer);
+        while (copier.next < N)
+        {
+            uint64_t pixels[2];
+            if (read_next_frame(consumer, copier, pixels) == -1)
+            {
+                wait_for_frame(storage, copier.next);
+                continue;
+            }
+            CHECK(copier.last_skipped == 0 && copier.last_overruns == 0);
+            CHECK(pixels[0] == copier.next - 1 && pixels[1] == ~pixels[0]);
+        } });
+
+    SharedStorage *storage = get_storage_ptr(consumer);
+    while (borrower.next < N)
+    {
+        const uint64_t *pixels = reinterpret_cast<const uint64_t *>(acquire_next_frame(consumer, borrower));
+        if (pixels == nullptr)
+        {
+            wait_for_frame(storage, borrower.next);
+            continue;
+        }
+        CHECK(borrower.last_skipped == 0);
+        CHECK(pixels[0] == borrower.next - 1 && pixels[1] == ~pixels[0]);
+        release_frames(consumer, borrower);
+    }
+
+    writer.join();
+    copy_reader.join();
+    CHECK(copier.skipped == 0 && borrower.skipped == 0 && copier.overruns == 0);
+    unregister_reader(consumer, copier);
+    unregister_reader(consumer, borrower);
+    close_shared_memory(producer);
+    shm_unlink("/tsan_stress_test.shm");
+}
+
+static void stress_tickets()
+{
+    shm_unlink("/tsan_stress_test.shm");
+    SharedMemory producer;
+    CHECK(create_open_shared_memory(producer, "tsan_stress_test", 2, DataType::UINT64, {}, 1, SHMIO_FUTEX) == 0);
+    SharedMemory &consumer = producer;
+    std::atomic<bool> done{false};
+
+    auto respond = [&]
+    {
+        SharedStorage *storage = get_storage_ptr(producer);
+        while (!done)
+        {
+            uint64_t ticket, argument;
+            if (poll_ticket_request(storage, ticket, argument) == 0)
+                CHECK(post_ticket_response(storage, ticket, argument * 3) == 0);
+            else
+                cpu_relax();
+        }
+    };
+    auto request = [&](const uint64_t _first)
+    {
+        SharedStorage *storage = get_storage_ptr(consumer);
+        for (uint64_t argument = _first; argument < _first + N; ++argument)
+        {
+            uint64_t ticket, result;
+            while (post_ticket_request(storage, argument, ticket) == -1) // queue full
+                cpu_relax();
+            CHECK(wait_for_ticket_response(storage, ticket, result) == 0 && result == argument * 3);
+        }
+    };
+    std::thread responders[2] = {std::thread(respond), std::thread(respond)};
+    std::thread requesters[3] = {std::thread(request, 0), std::thread(request, N), std::thread(request, 2 * N)};
+
+    for (std::thread &requester : requesters)
+        requester.join();
+    done = true;
+    for (std::thread &responder : responders)
+        responder.join();
+    close_shared_memory(producer);
+    shm_unlink("/tsan_stress_test.shm");
+}
+
+static void stress_coalesce()
+{
+    shm_unlink("/tsan_stress_test.shm");
+    SharedMemory producer;
+    CHECK(create_open_shared_memory(producer, "tsan_stress_test", 2, DataType::UINT64, {}, 1, SHMIO_FUTEX) == 0);
+    SharedMemory &consumer = producer;
+    std::vector<uint64_t> frames(3 * N + 2); // written once per generation before end_coalesced_frame()
+    std::atomic<bool> done{false};
+
+    std::thread responder([&]
+                          {
+        SharedStorage *storage = get_storage_ptr(producer);
+        while (!done)
+        {
+            struct timespec deadline = monotonic_deadline(1000000);
+            if (wait_for_coalesced_request_until(storage, &deadline) == -1)
+                continue;
+            uint32_t generation = begin_coalesced_frame(storage);
+            frames[generation] = generation * 3;
+            end_coalesced_frame(storage, generation);
+        } });
+
+    auto request = [&]
+    {
+        SharedStorage *storage = get_storage_ptr(consumer);
+        for (int i = 0; i < N; ++i)
+        {
+            uint32_t generation;
+            post_coalesced_request(storage, generation);
+            CHECK(wait_for_coalesced_response(storage, generation) == 0 && frames[generation] == generation * 3);
+        }
+    };
+    std::thread requesters[3] = {std::thread(request), std::thread(request), std::thread(request)};
+
+    for (std::thread &requester : requesters)
+        requester.join();
+    done = true;
+    responder.join();
+    close_shared_memory(producer);
+    shm_unlink("/tsan_stress_test.shm");
+}
+
+int main()
+{
+    stress(0);
+    stress(SHMIO_FUTEX);
+    stress_notify();
+    stress_ring();
+    stress_tickets();
+    stress_coalesce();
+    std::printf("ok\n");
+    return 0;
+}
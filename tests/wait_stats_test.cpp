@@ -0,0 +1,94 @@
+// WaitStats accounting of the waits that take one.
+//
+// A wait is counted once it returns: in the phase it was satisfied in, or as a timeout if its deadline passed, never
+// as a block that did not end with the condition met. Checked for wait_for_frame_until() and, per backend, for
+// wait_for_response_until() and wait_for_request_until().
+
+#include "shared_memory.hpp"
+
+#include <cstdio>
+#include <thread>
+
+using namespace shmio;
+
+#define CHECK(condition)                                                                 \
+    do                                                                                   \
+    {                                                                                    \
+        if (!(condition))                                                                \
+        {                                                                                \
+            std::printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition);   \
+            std::fflush(stdout);                                                         \
+            std::_Exit(1);                                                               \
+        }                                                                                \
+    } while (0)
+
+static constexpr uint64_t TIMEOUT_NS = 2000000;
+static const WaitPolicy BLOCK{WaitMode::BLOCK, 0, 0};
+static const WaitPolicy SPIN{WaitMode::SPIN_FOR, 0, 500000};
+
+static void check_frame_waits()
+{
+    shm_unlink("/wait_stats_test.shm");
+    SharedMemory memory;
+    CHECK(create_open_shared_memory(memory, "wait_stats_test", 16, DataType::UINT8, {}, 1) == 0);
+    SharedStorage *storage = get_storage_ptr(memory);
+
+    WaitStats stats;
+    for (const WaitPolicy &policy : {BLOCK, SPIN})
+    {
+        struct timespec deadline = monotonic_deadline(TIMEOUT_NS);
+        CHECK(wait_for_frame_until(storage, 0, &deadline, policy, &stats) == 0 && errno == ETIMEDOUT);
+    }
+    CHECK(stats.block == 0 && stats.spin == 0 && stats.immediate == 0 && stats.timeout == 2);
+
+    std::thread writer([&]
+                       {
+        usleep(10000);
+        begin_write(memory);
+        end_write(memory); });
+    CHECK(wait_for_frame(storage, 0, BLOCK, &stats) == 1);
+    writer.join();
+    CHECK(stats.block == 1 && stats.timeout == 2);
+
+    struct timespec deadline = monotonic_deadline(TIMEOUT_NS);
+    CHECK(wait_for_frame_until(storage, 0, &deadline, BLOCK, &stats) == 1);
+    CHECK(stats.immediate == 1 && stats.block == 1 && stats.timeout == 2);
+
+    close_shared_memory(memory);
+    shm_unlink("/wait_stats_test.shm");
+}
+
+static void check_handshake_waits(const uint32_t _flags)
+{
+    shm_unlink("/wait_stats_test.shm");
+    SharedMemory memory;
+    CHECK(create_open_shared_memory(memory, "wait_stats_test", 16, DataType::UINT8, {}, 1, _flags) == 0);
+    SharedStorage *storage = get_storage_ptr(memory);
+
+    WaitStats stats;
+    struct timespec deadline = monotonic_deadline(TIMEOUT_NS);
+    CHECK(wait_for_request_until(storage, &deadline, BLOCK, &stats) == -1 && errno == ETIMEDOUT);
+    deadline = monotonic_deadline(TIMEOUT_NS);
+    CHECK(wait_for_response_until(storage, &deadline, SPIN, &stats) == -1 && errno == ETIMEDOUT);
+    CHECK(stats.block == 0 && stats.spin == 0 && stats.immediate == 0 && stats.timeout == 2);
+
+    std::thread responder([&]
+                          {
+        usleep(10000);
+        post_response(storage); });
+    CHECK(wait_for_response(storage, BLOCK, &stats) == 0);
+    responder.join();
+    CHECK(stats.block == 1 && stats.timeout == 2);
+
+    close_shared_memory(memory);
+    shm_unlink("/wait_stats_test.shm");
+}
+
+int main()
+{
+    check_frame_waits();
+    check_handshake_waits(0);
+    check_handshake_waits(SHMIO_FUTEX);
+    std::printf("ok\n");
+    return 0;
+}